@@ -0,0 +1,50 @@
+/*
+ * Cycle-count benchmarking for hot-path stages
+ * Uses the per-core SysTick counter clocked from clk_sys, so each core
+ * must call bench_init_core() before timing anything.
+ * Compiles to nothing unless CONFIG_PICONTROLLER_BENCH is defined.
+ */
+
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+#include <stdint.h>
+
+#include "sdkconfig.h"
+
+// Accumulated cycle statistics for one measured stage
+typedef struct {
+    const char *name;
+    uint32_t count;
+    uint32_t total;
+    uint32_t min;
+    uint32_t max;
+} bench_stat_t;
+
+#define BENCH_STAT_INIT(stage_name) \
+    { .name = (stage_name), .count = 0, .total = 0, .min = UINT32_MAX, .max = 0 }
+
+#ifdef CONFIG_PICONTROLLER_BENCH
+
+// Start the SysTick counter on the calling core
+void bench_init_core(void);
+
+// Read the current cycle counter (counts down, 24 bits)
+uint32_t bench_start(void);
+
+// Record the cycles elapsed since bench_start() and return them
+uint32_t bench_stop(bench_stat_t *stat, uint32_t start);
+
+// Print and reset the statistics for a stage
+void bench_print(bench_stat_t *stat);
+
+#else
+
+static inline void bench_init_core(void) {}
+static inline uint32_t bench_start(void) { return 0; }
+static inline uint32_t bench_stop(bench_stat_t *stat, uint32_t start) { (void)stat; (void)start; return 0; }
+static inline void bench_print(bench_stat_t *stat) { (void)stat; }
+
+#endif /* CONFIG_PICONTROLLER_BENCH */
+
+#endif /* _BENCH_H_ */
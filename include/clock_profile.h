@@ -0,0 +1,32 @@
+/*
+ * System clock profiles (Core 0, at startup)
+ * The profile is chosen at configure time (PICONTROLLER_CLOCK_PROFILE in
+ * CMakeLists.txt) and applied before stdio comes up; a self-check then
+ * verifies the clock and flash reads and falls back to the default
+ * profile if either is off.
+ */
+
+#ifndef _CLOCK_PROFILE_H_
+#define _CLOCK_PROFILE_H_
+
+#include <stdbool.h>
+
+#include <hardware/vreg.h>
+
+#include "sdkconfig.h"
+
+#define CLOCK_PROFILE_DEFAULT 0      // boot clock and voltage of the chip
+#define CLOCK_PROFILE_PERFORMANCE 1  // overclock, raised voltage, slower flash
+#define CLOCK_PROFILE_LOW_POWER 2    // reduced clock and voltage
+
+// Switch to the configured profile (call first in main, before stdio)
+void clock_profile_apply(void);
+
+// Verify the clock and flash reads at the new settings, fall back to the
+// default profile on failure and log the result (call once stdio is up)
+bool clock_profile_check(void);
+
+// Core voltage of the running profile (restored when leaving idle)
+enum vreg_voltage clock_profile_voltage(void);
+
+#endif /* _CLOCK_PROFILE_H_ */
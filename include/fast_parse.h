@@ -0,0 +1,30 @@
+/*
+ * Fast-path input report parsers for common controllers
+ * Decode a raw Bluetooth HID input report (report ID first) straight into
+ * a raw_sample_t in one pass, replacing bluepad32's parser plus
+ * translate_fill_sample(). Output uses bluepad32 bits and units before
+ * any button remapping; timestamp and epoch are left to the caller.
+ * Report types not listed return false and go through bluepad32, as do
+ * all pads of other families (Switch Pro included, see fast_parse.c).
+ */
+
+#ifndef _FAST_PARSE_H_
+#define _FAST_PARSE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "raw_sample.h"
+
+// Controller families (CONFIG_PICONTROLLER_FAST_PARSE_PADS bits)
+#define FAST_PARSE_DS4 (1U << 0)     // DualShock 4, report 0x11
+#define FAST_PARSE_DS5 (1U << 1)     // DualSense, report 0x31
+#define FAST_PARSE_XBOX (1U << 2)    // Xbox Wireless (firmware 5.x), report 0x01
+
+typedef bool (*fast_parse_fn_t)(const uint8_t *report, uint16_t len, raw_sample_t *sample);
+
+bool fast_parse_ds4(const uint8_t *report, uint16_t len, raw_sample_t *sample);
+bool fast_parse_ds5(const uint8_t *report, uint16_t len, raw_sample_t *sample);
+bool fast_parse_xbox(const uint8_t *report, uint16_t len, raw_sample_t *sample);
+
+#endif /* _FAST_PARSE_H_ */
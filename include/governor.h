@@ -0,0 +1,31 @@
+/*
+ * Idle clock and voltage governor (runs on Core 0)
+ * Drops the system clock and core voltage while no controller is
+ * connected or USB is suspended, and parks Core 0 between polls.
+ * Compiles to nothing unless CONFIG_PICONTROLLER_GOVERNOR is defined.
+ */
+
+#ifndef _GOVERNOR_H_
+#define _GOVERNOR_H_
+
+#include <stdbool.h>
+
+#include "sdkconfig.h"
+
+#ifdef CONFIG_PICONTROLLER_GOVERNOR
+
+// Remember the full-speed clock (call once before the USB main loop)
+void governor_init(void);
+
+// Switch between full speed and idle; parks Core 0 briefly while idle
+// (call every main loop iteration)
+void governor_poll(bool usb_suspended);
+
+#else
+
+static inline void governor_init(void) {}
+static inline void governor_poll(bool usb_suspended) { (void)usb_suspended; }
+
+#endif /* CONFIG_PICONTROLLER_GOVERNOR */
+
+#endif /* _GOVERNOR_H_ */
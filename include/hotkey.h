@@ -0,0 +1,65 @@
+/*
+ * Chorded hotkey layer
+ * A modifier button held together with a key fires an action, and the
+ * whole chord is removed from the report so it never reaches the console.
+ * A held-back modifier pressed on its own is replayed as a short tap on
+ * release, or passed through once held long enough, so its normal
+ * function survives; otherwise the modifier passes through at once and is
+ * only removed once a chord completes. Timing is in USB frames; runs on
+ * Core 0.
+ */
+
+#ifndef _HOTKEY_H_
+#define _HOTKEY_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "switch_descriptors.h"
+
+typedef void (*hotkey_action_t)(uint8_t arg, uint32_t frame);
+
+// Modifier + button fires action(arg)
+typedef struct {
+    uint16_t button;
+    hotkey_action_t action;
+    uint8_t arg;
+} hotkey_t;
+
+typedef enum {
+    HOTKEY_IDLE,
+    HOTKEY_PENDING,
+    HOTKEY_CHORD,
+    HOTKEY_PASSTHROUGH,
+    HOTKEY_TAP,
+} hotkey_state_t;
+
+typedef struct {
+    uint16_t modifier;
+    bool hold_modifier;  // keep the modifier from the console until released
+    uint16_t key_mask;
+    const hotkey_t *keys;
+    uint8_t key_count;
+    hotkey_state_t state;
+    uint32_t state_frame;
+    uint16_t previous_buttons;
+} hotkey_layer_t;
+
+// Set up a layer for a modifier and its keys
+void hotkey_layer_init(hotkey_layer_t *layer, uint16_t modifier, bool hold_modifier,
+                       const hotkey_t *keys, uint8_t key_count);
+
+// Run the state machine once the modifier is involved
+void hotkey_layer_update(hotkey_layer_t *layer, SwitchOutReport *report, uint32_t frame);
+
+// Per-report entry point: a mask test and a store unless the modifier is
+// involved
+static inline void hotkey_layer_apply(hotkey_layer_t *layer, SwitchOutReport *report, uint32_t frame) {
+    if (layer->state != HOTKEY_IDLE || (report->buttons & layer->modifier)) {
+        hotkey_layer_update(layer, report, frame);
+    } else {
+        layer->previous_buttons = report->buttons;
+    }
+}
+
+#endif /* _HOTKEY_H_ */
@@ -0,0 +1,46 @@
+/*
+ * Virtual controller input over the debug UART
+ *
+ * A host streams gamepad states as small binary frames into the stdio
+ * UART (BTstack stdin, HAVE_BTSTACK_STDIN). Each valid frame is decoded
+ * into a uni_gamepad_t and handed to the same translation path as a
+ * Bluetooth controller. Frame slot n is report slot
+ * CONFIG_BLUEPAD32_MAX_DEVICES + n; frames for slots past
+ * CONFIG_PICONTROLLER_INJECT_SLOTS are dropped. Runs on Core 1 inside the
+ * BTstack run loop.
+ * tools/inject.py generates frames.
+ *
+ * Frame layout (21 bytes, little endian):
+ *   0   2  sync 0xA5 0x5A
+ *   2   1  slot (bits 0-3), flags (bits 4-7)
+ *   3   1  sequence number, incremented per frame
+ *   4   2  buttons (bluepad32 BUTTON_* bits)
+ *   6   1  dpad (bluepad32 DPAD_* bits)
+ *   7   1  misc buttons (bluepad32 MISC_BUTTON_* bits)
+ *   8   8  axis x, y, rx, ry (int16, -512..511)
+ *   16  4  brake, throttle (uint16, 0..1023)
+ *   20  1  checksum: bytes 2..20 sum to zero (mod 256)
+ */
+
+#ifndef _INJECT_H_
+#define _INJECT_H_
+
+#include <stdint.h>
+
+#include <uni.h>
+
+#define INJECT_FRAME_SIZE 21
+#define INJECT_SYNC0 0xA5
+#define INJECT_SYNC1 0x5A
+
+// Flags (upper nibble of byte 2)
+#define INJECT_FLAG_DISCONNECT (1U << 4)  // drop the virtual controller
+
+// Called for each decoded frame with the virtual slot (0 based);
+// gp is NULL for a disconnect
+typedef void (*inject_handler_t)(uint8_t slot, uni_gamepad_t *gp);
+
+// Start listening on stdin (call once BTstack is up)
+void inject_start(inject_handler_t handler);
+
+#endif /* _INJECT_H_ */
@@ -0,0 +1,31 @@
+/*
+ * Keyboard and mouse to Switch controller translation
+ *
+ * Core 1 (Bluetooth): keys map to buttons, the hat and the left stick;
+ * mouse motion is added to a lock-free delta accumulator.
+ * Core 0 (USB): drains the accumulator once per USB frame into a
+ * right-stick model with sensitivity and decay.
+ */
+
+#ifndef _KBM_H_
+#define _KBM_H_
+
+#include <stdint.h>
+
+#include <uni.h>
+
+#include "switch_descriptors.h"
+
+// Translate a keyboard state into a report (Core 1)
+void kbm_fill_keyboard_report(const uni_keyboard_t *kb, SwitchOutReport *report);
+
+// Translate mouse buttons into a report and accumulate motion (Core 1)
+void kbm_fill_mouse_report(const uni_mouse_t *mouse, SwitchOutReport *report);
+
+// Drain accumulated motion and advance the stick model (Core 0, once per frame)
+void kbm_mouse_frame(uint32_t frames_elapsed);
+
+// Overlay the mouse stick onto the right stick while it is moving (Core 0)
+void kbm_mouse_apply(SwitchOutReport *report);
+
+#endif /* _KBM_H_ */
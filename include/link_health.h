@@ -0,0 +1,42 @@
+/*
+ * Bluetooth link health monitor (runs on Core 1)
+ * Tracks report inter-arrival times, gaps, RSSI and link quality per
+ * controller, logs them periodically over the UART and acts on links that
+ * stay degraded: first by renegotiating the link, then by dropping it so
+ * the controller reconnects.
+ * Compiles to nothing unless CONFIG_PICONTROLLER_LINK_HEALTH is defined.
+ */
+
+#ifndef _LINK_HEALTH_H_
+#define _LINK_HEALTH_H_
+
+#include <stdint.h>
+
+#include <uni.h>
+
+#include "sdkconfig.h"
+
+#ifdef CONFIG_PICONTROLLER_LINK_HEALTH
+
+// Register for HCI events and start the evaluation timer (BTstack is up)
+void link_health_start(void);
+
+// A controller connected on this slot
+void link_health_connected(int idx, hci_con_handle_t handle);
+
+// The controller on this slot disconnected; logs its totals
+void link_health_disconnected(int idx);
+
+// A report arrived from the controller on this slot
+void link_health_report(int idx);
+
+#else
+
+static inline void link_health_start(void) {}
+static inline void link_health_connected(int idx, hci_con_handle_t handle) { (void)idx; (void)handle; }
+static inline void link_health_disconnected(int idx) { (void)idx; }
+static inline void link_health_report(int idx) { (void)idx; }
+
+#endif /* CONFIG_PICONTROLLER_LINK_HEALTH */
+
+#endif /* _LINK_HEALTH_H_ */
@@ -0,0 +1,59 @@
+/*
+ * Frame-accurate macro and turbo engine
+ * Runs on Core 0 and is merged into the outgoing report just before it is
+ * handed to TinyUSB. All timing is in USB frames (1 ms at full speed), so
+ * playback is independent of Bluetooth report jitter.
+ */
+
+#ifndef _MACRO_H_
+#define _MACRO_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "switch_descriptors.h"
+
+// Step flags
+#define MACRO_STEP_LEFT_STICK  (1U << 0)  // Override lx/ly
+#define MACRO_STEP_RIGHT_STICK (1U << 1)  // Override rx/ry
+
+// One timed step: buttons are OR-ed into the report, the hat and sticks
+// override it when set
+typedef struct {
+    uint16_t buttons;
+    uint8_t hat;
+    uint8_t flags;
+    uint8_t lx;
+    uint8_t ly;
+    uint8_t rx;
+    uint8_t ry;
+    uint16_t frames;
+} macro_step_t;
+
+typedef struct {
+    const char *name;
+    const macro_step_t *steps;
+    uint8_t step_count;
+    bool loop;
+} macro_t;
+
+// Initialize the engine (starts the configured autostart macro, if any)
+void macro_init(uint32_t frame);
+
+// Start or stop playback of macro index
+void macro_play(uint8_t index, uint32_t frame);
+void macro_stop(void);
+
+// Toggle turbo on the configured buttons
+void macro_toggle_turbo(uint32_t frame);
+
+// Change which buttons turbo repeats and its timing (frames)
+void macro_set_turbo(uint16_t mask, uint8_t period, uint8_t on);
+
+// Handle trigger combos (physical buttons, before any profile remap)
+void macro_triggers(SwitchOutReport *report, uint32_t frame);
+
+// Merge macro and turbo output into the report (after the remap)
+void macro_apply(SwitchOutReport *report, uint32_t frame);
+
+#endif /* _MACRO_H_ */
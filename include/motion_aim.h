@@ -0,0 +1,39 @@
+/*
+ * Gyro-to-stick motion aiming
+ * Converts gamepad angular rate into right-stick deflection, so the game
+ * turns the camera at a speed proportional to how fast the pad rotates.
+ * All math is 32-bit fixed point (RP2040 has no FPU).
+ */
+
+#ifndef _MOTION_AIM_H_
+#define _MOTION_AIM_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "switch_descriptors.h"
+
+// Per-axis filter state (values in gyro counts, Q8)
+typedef struct {
+    int32_t bias_q8;      // Estimated zero-rate offset
+    int32_t lowpass_q8;   // Filtered, bias-corrected rate
+    uint16_t still_count; // Consecutive samples within the stillness band
+} motion_aim_axis_t;
+
+// Per-controller motion aiming state
+typedef struct {
+    motion_aim_axis_t yaw;
+    motion_aim_axis_t pitch;
+} motion_aim_t;
+
+// Reset filter state (call on connect/disconnect)
+void motion_aim_reset(motion_aim_t *aim);
+
+// Feed one gyro sample and add the resulting deflection to rx/ry.
+// ratchet: when true the gyro output is suspended (like lifting a mouse).
+void motion_aim_update(motion_aim_t *aim,
+                       const int32_t gyro[3],
+                       bool ratchet,
+                       SwitchOutReport *report);
+
+#endif /* _MOTION_AIM_H_ */
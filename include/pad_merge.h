@@ -0,0 +1,24 @@
+/*
+ * Two-pad merge ("co-pilot") rules
+ * Combines the reports of several controllers into one Switch report.
+ * Runs on Core 0 once per USB frame.
+ */
+
+#ifndef _PAD_MERGE_H_
+#define _PAD_MERGE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "switch_descriptors.h"
+
+// Stick merge modes
+#define PAD_MERGE_STICK_MAX      0  // Largest deflection wins
+#define PAD_MERGE_STICK_PRIORITY 1  // Lowest slot past the threshold wins, else lowest active slot
+#define PAD_MERGE_STICK_PAD0     2  // Owned by slot 0
+#define PAD_MERGE_STICK_PAD1     3  // Owned by slot 1
+
+// Merge count reports into out; inactive slots are ignored
+void pad_merge(const SwitchOutReport *pads, const bool *active, uint8_t count, SwitchOutReport *out);
+
+#endif /* _PAD_MERGE_H_ */
@@ -0,0 +1,46 @@
+/*
+ * Runtime mapping profiles
+ * Each profile bundles a button remap, a stick response curve and turbo
+ * settings. Tables are built once at startup; switching profiles is a
+ * single pointer store, so the per-report cost never depends on which
+ * profile is active. HOME is the hotkey modifier (see profile.c).
+ * Runs on Core 0: hotkeys see the physical buttons, the remap runs after
+ * the macro triggers and before macro and turbo output.
+ */
+
+#ifndef _PROFILE_H_
+#define _PROFILE_H_
+
+#include <stdint.h>
+
+#include "switch_descriptors.h"
+
+// Stick response curves
+#define PROFILE_CURVE_LINEAR     0
+#define PROFILE_CURVE_PRECISE    1  // finer control near center
+#define PROFILE_CURVE_AGGRESSIVE 2  // reaches full speed sooner
+
+// Prebuilt tables for one profile
+typedef struct {
+    const char *name;
+    uint16_t buttons_lo[256];  // remapped buttons for report bits 0-7
+    uint16_t buttons_hi[256];  // remapped buttons for report bits 8-15
+    uint8_t stick[256];        // stick response curve, all four axes
+    uint16_t turbo_mask;
+    uint8_t turbo_period;
+    uint8_t turbo_on;
+} profile_t;
+
+// Build every profile's tables and activate the default profile
+void profile_init(void);
+
+// Activate a profile (ignored if out of range)
+void profile_select(uint8_t index);
+
+// Handle HOME hotkeys on the physical buttons
+void profile_hotkeys(SwitchOutReport *report, uint32_t frame);
+
+// Remap buttons and shape the sticks
+void profile_apply(SwitchOutReport *report);
+
+#endif /* _PROFILE_H_ */
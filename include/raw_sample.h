@@ -0,0 +1,29 @@
+/*
+ * Normalized controller sample
+ *
+ * What Core 1 captures from one bluepad32 gamepad state (or a fast-path
+ * parse) before translation. Kept free of bluepad32 headers so the report
+ * slots on Core 0 can carry it.
+ */
+
+#ifndef _RAW_SAMPLE_H_
+#define _RAW_SAMPLE_H_
+
+#include <stdint.h>
+
+#include "stick_filter.h"
+
+// Normalized controller state (bluepad32 bits and units)
+typedef struct {
+    uint32_t timestamp_us;
+    uint16_t buttons;
+    uint8_t dpad;
+    uint8_t misc_buttons;
+    int16_t axes[STICK_AXIS_COUNT];  // x, y, rx, ry
+    uint16_t brake;
+    uint16_t throttle;
+    int32_t gyro[3];
+    uint8_t epoch;                   // changes whenever a new controller takes the pad
+} raw_sample_t;
+
+#endif /* _RAW_SAMPLE_H_ */
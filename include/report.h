@@ -1,18 +1,49 @@
 /*
- * Thread-safe gamepad report sharing between cores
- * Core 1 (Bluetooth) sets the report
- * Core 0 (USB) gets the report
+ * Lock-free gamepad report sharing between cores
+ * Core 1 (Bluetooth) publishes one report per controller slot
+ * Core 0 (USB) merges the active slots into the outgoing report
  */
 
 #ifndef _REPORT_H_
 #define _REPORT_H_
 
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "sdkconfig.h"
+#include "raw_sample.h"
 #include "switch_descriptors.h"
 
-// Set the gamepad report (called from Core 1 - Bluetooth)
-void set_global_gamepad_report(const SwitchOutReport *report);
+// Controller slots: Bluetooth pads first, then virtual ones (inject.h)
+#ifdef CONFIG_PICONTROLLER_INJECT
+#define GAMEPAD_SLOTS (CONFIG_BLUEPAD32_MAX_DEVICES + CONFIG_PICONTROLLER_INJECT_SLOTS)
+#else
+#define GAMEPAD_SLOTS CONFIG_BLUEPAD32_MAX_DEVICES
+#endif
+
+// Set the report for a controller slot (called from Core 1 - Bluetooth)
+void set_global_gamepad_report(uint8_t pad, const SwitchOutReport *report);
+
+#ifdef CONFIG_PICONTROLLER_RAW_HANDOFF
+// Set a raw controller sample for a slot, translated on Core 0 (Core 1)
+void set_global_gamepad_sample(uint8_t pad, const raw_sample_t *sample);
+#endif
+
+// Mark a controller slot as connected or not (called from Core 1)
+void set_global_gamepad_active(uint8_t pad, bool active);
 
-// Get the gamepad report (called from Core 0 - USB)
+// Drop a slot from the merge when it goes deadline_ms without an update,
+// 0 = never (for pads that only report on change; called from Core 1)
+void set_global_gamepad_deadline(uint8_t pad, uint32_t deadline_ms);
+
+// Record that the Bluetooth core is alive (called periodically from Core 1)
+void set_global_heartbeat(void);
+
+// Get the merged gamepad report (called from Core 0 - USB)
+// Stale slots and a silent Bluetooth core yield neutral input
 void get_global_gamepad_report(SwitchOutReport *report);
 
+// True while any controller slot is active (Core 0)
+bool get_global_gamepad_any_active(void);
+
 #endif /* _REPORT_H_ */
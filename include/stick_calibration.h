@@ -0,0 +1,108 @@
+/*
+ * Per-device stick calibration keyed by Bluetooth address
+ *
+ * Each controller gets a learned center and min/max per axis. The result
+ * is folded into a 1024-entry lookup table per axis that also applies the
+ * deadzone and the conversion to Switch units, so applying calibration is
+ * a single table load per axis and sample.
+ *
+ * Learned calibrations live in a small table that is persisted through
+ * the BTstack TLV store (same flash bank as the link keys). All functions
+ * but stick_calibration_apply() must be called from the Bluetooth core.
+ * Learning from samples only updates the ranges; tables are rebuilt and
+ * manual results saved later by stick_calibration_update(), outside the
+ * report path.
+ *
+ * The tables are double buffered under a sequence counter, so the core
+ * that translates (Core 0 with CONFIG_PICONTROLLER_RAW_HANDOFF) never sees
+ * a half-built table: a rebuild fills the idle buffer and then publishes
+ * it, and a reader retries only if a second rebuild started on the buffer
+ * it was reading.
+ */
+
+#ifndef _STICK_CALIBRATION_H_
+#define _STICK_CALIBRATION_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <bluetooth.h>
+
+#include "stick_filter.h"
+
+// bluepad32 axis range
+#define STICK_RAW_MIN  (-512)
+#define STICK_RAW_MAX  511
+#define STICK_LUT_SIZE 1024
+
+// Learned range for one axis (bluepad32 units)
+typedef struct {
+    int16_t center;
+    int16_t min;
+    int16_t max;
+} stick_calibration_axis_t;
+
+// Stored calibration for one controller (42 bytes)
+typedef struct {
+    bd_addr_t addr;
+    stick_calibration_axis_t axis[STICK_AXIS_COUNT];
+    int16_t pending_center[STICK_AXIS_COUNT];  // learned once, stored when confirmed
+    uint16_t last_used;
+    uint8_t valid;
+    uint8_t pending;                           // pending_center is set
+} stick_calibration_entry_t;
+
+typedef enum {
+    STICK_CALIBRATION_AUTO,
+    STICK_CALIBRATION_MANUAL,
+} stick_calibration_mode_t;
+
+// Per-controller calibration state
+typedef struct {
+    // Published tables; attach leaves them alone so a reader stays valid
+    uint8_t lut[2][STICK_AXIS_COUNT][STICK_LUT_SIZE];
+    volatile uint32_t lut_sequence;  // odd while the idle buffer is rebuilt
+
+    stick_calibration_entry_t entry;
+    stick_calibration_mode_t mode;
+    int16_t stored_center[STICK_AXIS_COUNT];  // center loaded at attach
+    int32_t rest_sum[STICK_AXIS_COUNT];
+    int32_t rest_min[STICK_AXIS_COUNT];
+    int32_t rest_max[STICK_AXIS_COUNT];
+    int32_t prev[STICK_AXIS_COUNT];
+    uint16_t rest_count;
+    bool center_locked;
+    bool center_learned;  // center came from this connection's rest samples
+    bool rebuild;         // tables out of date
+    bool save;            // manual result waiting to be stored
+} stick_calibration_t;
+
+// Load the stored table from flash (call once BTstack is up)
+void stick_calibration_load(void);
+
+// Look up (or create) the calibration for a controller and build its tables
+void stick_calibration_attach(stick_calibration_t *cal, const bd_addr_t addr);
+
+// Full nominal range with a fixed center, never persisted (virtual controllers)
+void stick_calibration_attach_nominal(stick_calibration_t *cal);
+
+// Persist learned changes worth a flash write (call on disconnect)
+void stick_calibration_detach(stick_calibration_t *cal);
+
+// Learn from one raw sample (bluepad32 units)
+void stick_calibration_observe(stick_calibration_t *cal, const int32_t axes[STICK_AXIS_COUNT]);
+
+// Rebuild stale tables and store a finished manual calibration (call from
+// a run loop timer, not from the report callback)
+void stick_calibration_update(stick_calibration_t *cal);
+
+// Manual calibration: begin with sticks released, rotate them, then end
+void stick_calibration_begin_manual(stick_calibration_t *cal, const int32_t axes[STICK_AXIS_COUNT]);
+void stick_calibration_end_manual(stick_calibration_t *cal);
+
+// Convert raw axis values to Switch units through the published tables;
+// neutral while a manual calibration runs (any core)
+void stick_calibration_apply(const stick_calibration_t *cal, const int32_t raw[STICK_AXIS_COUNT],
+                             uint8_t out[STICK_AXIS_COUNT]);
+
+#endif /* _STICK_CALIBRATION_H_ */
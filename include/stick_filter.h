@@ -0,0 +1,41 @@
+/*
+ * Adaptive stick smoothing (One-Euro filter) in fixed point
+ * Slow movement gets a low cutoff (strong smoothing of jitter), fast
+ * movement raises the cutoff so flicks pass through with little lag.
+ */
+
+#ifndef _STICK_FILTER_H_
+#define _STICK_FILTER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Axis order used throughout: left X/Y, right X/Y
+#define STICK_AXIS_COUNT 4
+
+// Per-axis filter state
+typedef struct {
+    int32_t x_q4;  // Filtered position (bluepad32 units, Q4)
+    int32_t dx;    // Filtered speed (bluepad32 units per second)
+} stick_filter_axis_t;
+
+// Per-controller filter state
+typedef struct {
+    stick_filter_axis_t axis[STICK_AXIS_COUNT];
+    uint32_t last_us;
+    bool primed;
+} stick_filter_t;
+
+// Reset filter state (call on connect/disconnect)
+void stick_filter_reset(stick_filter_t *filter);
+
+// Filter one sample in place (bluepad32 units, -512..511)
+void stick_filter_update(stick_filter_t *filter, int32_t axes[STICK_AXIS_COUNT], uint32_t now_us);
+
+// Group delay added by a one-pole stage at the given cutoff and sample interval
+uint32_t stick_filter_group_delay_us(uint32_t cutoff_chz, uint32_t interval_us);
+
+// Log the added group delay of the configured filter for typical intervals
+void stick_filter_log_config(void);
+
+#endif /* _STICK_FILTER_H_ */
@@ -0,0 +1,42 @@
+/*
+ * Short-horizon stick extrapolation in fixed point
+ * Bluetooth pads report every 4-15 ms while USB sends every 1 ms. Between
+ * reports the held stick position is extrapolated along the recent
+ * velocity towards the frame being sent, bounded in time and never
+ * further than the last observed step. Runs on Core 0, per slot.
+ */
+
+#ifndef _STICK_PREDICT_H_
+#define _STICK_PREDICT_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "switch_descriptors.h"
+
+#define STICK_PREDICT_AXES 4
+
+// Per-axis state (Switch units, Q8)
+typedef struct {
+    int32_t pos_q8;   // newest sample
+    int32_t step_q8;  // change from the previous sample
+    int32_t vel_q8;   // smoothed speed, units per millisecond
+} stick_predict_axis_t;
+
+// Per-slot predictor state
+typedef struct {
+    stick_predict_axis_t axis[STICK_PREDICT_AXES];
+    uint32_t sample_us;
+    uint32_t horizon_us;
+    bool primed;
+} stick_predict_t;
+
+// Reset state; horizon_us (at most 16 ms) bounds how far ahead of a sample
+// to extrapolate
+void stick_predict_reset(stick_predict_t *predict, uint32_t horizon_us);
+
+// Replace the sticks in report (the newest sample, taken at sample_us)
+// with their extrapolated position at now_us
+void stick_predict_apply(stick_predict_t *predict, uint32_t sample_us, uint32_t now_us, SwitchOutReport *report);
+
+#endif /* _STICK_PREDICT_H_ */
@@ -0,0 +1,32 @@
+/*
+ * Controller sample to Switch report translation
+ *
+ * Core 1 reduces each bluepad32 gamepad state to a raw_sample_t. The
+ * sample is then mapped to a SwitchOutReport (buttons, D-pad, stick
+ * smoothing, calibration tables, motion aim) by whichever core owns
+ * translation: Core 1 by default, or Core 0 right before the report is
+ * sent with CONFIG_PICONTROLLER_RAW_HANDOFF. Only that core may call
+ * translate_pad().
+ */
+
+#ifndef _TRANSLATE_H_
+#define _TRANSLATE_H_
+
+#include <stdint.h>
+
+#include <uni.h>
+
+#include "raw_sample.h"
+#include "stick_calibration.h"
+#include "switch_descriptors.h"
+
+// Bind the per-pad calibration tables (Core 1, at platform init)
+void translate_init(const stick_calibration_t *calibrations);
+
+// Capture a bluepad32 gamepad state (Core 1)
+void translate_fill_sample(raw_sample_t *sample, const uni_gamepad_t *gp, uint8_t epoch, uint32_t now_us);
+
+// Translate one sample for a pad; smoothing and aim state reset on a new epoch
+void translate_pad(uint8_t pad, const raw_sample_t *sample, SwitchOutReport *report);
+
+#endif /* _TRANSLATE_H_ */
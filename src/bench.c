@@ -0,0 +1,66 @@
+/*
+ * Cycle-count benchmarking for hot-path stages
+ */
+
+#include "bench.h"
+
+#ifdef CONFIG_PICONTROLLER_BENCH
+
+#include <stdio.h>
+
+#include <hardware/clocks.h>
+#include <hardware/structs/systick.h>
+
+// SysTick is a 24-bit down-counter
+#define SYSTICK_MASK 0x00FFFFFFu
+
+void bench_init_core(void) {
+    systick_hw->csr = 0;
+    systick_hw->rvr = SYSTICK_MASK;
+    systick_hw->cvr = 0;
+    // Enable, processor clock source, no interrupt
+    systick_hw->csr = 0x5;
+}
+
+uint32_t bench_start(void) {
+    return systick_hw->cvr;
+}
+
+uint32_t bench_stop(bench_stat_t *stat, uint32_t start) {
+    uint32_t cycles = (start - systick_hw->cvr) & SYSTICK_MASK;
+
+    stat->count++;
+    stat->total += cycles;
+    if (cycles < stat->min) {
+        stat->min = cycles;
+    }
+    if (cycles > stat->max) {
+        stat->max = cycles;
+    }
+    return cycles;
+}
+
+void bench_print(bench_stat_t *stat) {
+    if (stat->count == 0) {
+        return;
+    }
+
+    uint32_t mhz = clock_get_hz(clk_sys) / 1000000;
+    uint32_t avg = stat->total / stat->count;
+
+    printf("bench: %s n=%lu cycles min=%lu avg=%lu max=%lu (max %lu us @ %lu MHz)\n",
+           stat->name,
+           (unsigned long)stat->count,
+           (unsigned long)stat->min,
+           (unsigned long)avg,
+           (unsigned long)stat->max,
+           (unsigned long)(mhz ? stat->max / mhz : 0),
+           (unsigned long)mhz);
+
+    stat->count = 0;
+    stat->total = 0;
+    stat->min = UINT32_MAX;
+    stat->max = 0;
+}
+
+#endif /* CONFIG_PICONTROLLER_BENCH */
@@ -0,0 +1,171 @@
+/*
+ * System clock profiles (Core 0, at startup)
+ *
+ * Runs before Core 1 is launched and before stdio, so nothing else is
+ * using the clocks while they change. The voltage is raised before the
+ * clock goes up and lowered only after it came down. On RP2040 the flash
+ * divider for the performance profile is built into boot stage 2 (see
+ * CMakeLists.txt); RP2350 has no boot stage 2 here, so the QMI divider is
+ * raised at runtime before the clock.
+ *
+ * The self-check measures clk_sys with the frequency counter and reads
+ * the start of the image twice through the uncached XIP window, comparing
+ * it with the cached copy, so marginal flash timing shows up at boot
+ * instead of as a crash in the field. A failed check restores the chip's
+ * default clock and voltage. Passing it is not a validation of the
+ * profile: the non-default profiles have not been run on hardware yet.
+ */
+
+#include "clock_profile.h"
+
+#include <stdio.h>
+
+#include <pico/stdlib.h>
+#include <hardware/clocks.h>
+#include <hardware/sync.h>
+#include <hardware/uart.h>
+#include <hardware/regs/addressmap.h>
+#if PICO_RP2350
+#include <hardware/structs/qmi.h>
+#endif
+
+#if PICO_RP2350
+#define CHIP_NAME "RP2350"
+#define PROFILE_PERFORMANCE_KHZ CONFIG_PICONTROLLER_CLOCK_RP2350_PERFORMANCE_KHZ
+#define PROFILE_PERFORMANCE_VOLTAGE CONFIG_PICONTROLLER_CLOCK_RP2350_PERFORMANCE_VOLTAGE
+#else
+#define CHIP_NAME "RP2040"
+#define PROFILE_PERFORMANCE_KHZ CONFIG_PICONTROLLER_CLOCK_RP2040_PERFORMANCE_KHZ
+#define PROFILE_PERFORMANCE_VOLTAGE CONFIG_PICONTROLLER_CLOCK_RP2040_PERFORMANCE_VOLTAGE
+#endif
+
+#if CONFIG_PICONTROLLER_CLOCK_PROFILE == CLOCK_PROFILE_PERFORMANCE
+#define PROFILE_NAME "performance"
+#define PROFILE_KHZ PROFILE_PERFORMANCE_KHZ
+#define PROFILE_VOLTAGE PROFILE_PERFORMANCE_VOLTAGE
+#elif CONFIG_PICONTROLLER_CLOCK_PROFILE == CLOCK_PROFILE_LOW_POWER
+#define PROFILE_NAME "low_power"
+#define PROFILE_KHZ CONFIG_PICONTROLLER_CLOCK_LOW_POWER_KHZ
+#define PROFILE_VOLTAGE CONFIG_PICONTROLLER_CLOCK_LOW_POWER_VOLTAGE
+#else
+#define PROFILE_NAME "default"
+#define PROFILE_KHZ SYS_CLK_KHZ
+#define PROFILE_VOLTAGE VREG_VOLTAGE_DEFAULT
+#endif
+
+#ifndef CYW43_PIO_CLOCK_DIV_INT
+#define CYW43_PIO_CLOCK_DIV_INT 2  // SDK default
+#endif
+
+// Start of the program image in flash (linker script)
+extern char __flash_binary_start;
+
+static const char *active_name = PROFILE_NAME;
+static enum vreg_voltage active_voltage = VREG_VOLTAGE_DEFAULT;
+#if CONFIG_PICONTROLLER_CLOCK_PROFILE != CLOCK_PROFILE_DEFAULT
+static bool applied;
+#endif
+
+#if PICO_RP2350 && CONFIG_PICONTROLLER_FLASH_CLKDIV > 0
+// Runs from RAM with interrupts off: flash cannot be read while its
+// timing changes. The divider is only ever raised.
+static void __no_inline_not_in_flash_func(raise_flash_divider)(uint32_t div) {
+    uint32_t timing = qmi_hw->m[0].timing;
+    if (((timing & QMI_M0_TIMING_CLKDIV_BITS) >> QMI_M0_TIMING_CLKDIV_LSB) < div) {
+        qmi_hw->m[0].timing = (timing & ~QMI_M0_TIMING_CLKDIV_BITS) | (div << QMI_M0_TIMING_CLKDIV_LSB);
+        __dsb();
+    }
+}
+#endif
+
+void clock_profile_apply(void) {
+#if CONFIG_PICONTROLLER_CLOCK_PROFILE != CLOCK_PROFILE_DEFAULT
+#if PICO_RP2350 && CONFIG_PICONTROLLER_FLASH_CLKDIV > 0
+    uint32_t irq = save_and_disable_interrupts();
+    raise_flash_divider(CONFIG_PICONTROLLER_FLASH_CLKDIV);
+    restore_interrupts(irq);
+#endif
+
+    // Voltage up before the clock goes up, down after it came down
+    if (PROFILE_VOLTAGE > VREG_VOLTAGE_DEFAULT) {
+        vreg_set_voltage(PROFILE_VOLTAGE);
+        busy_wait_us_32(CONFIG_PICONTROLLER_CLOCK_VREG_SETTLE_US);
+    }
+
+    applied = set_sys_clock_khz(PROFILE_KHZ, false);
+    if (applied) {
+        if (PROFILE_VOLTAGE < VREG_VOLTAGE_DEFAULT) {
+            vreg_set_voltage(PROFILE_VOLTAGE);
+        }
+        active_voltage = PROFILE_VOLTAGE;
+    } else {
+        vreg_set_voltage(VREG_VOLTAGE_DEFAULT);
+    }
+#endif
+}
+
+// Back to the boot clock and voltage after a failed check
+static void fall_back(void) {
+    set_sys_clock_khz(SYS_CLK_KHZ, true);
+    vreg_set_voltage(VREG_VOLTAGE_DEFAULT);
+#if defined(LIB_PICO_STDIO_UART) && defined(uart_default)
+    // clk_peri follows clk_sys
+    uart_set_baudrate(uart_default, PICO_DEFAULT_UART_BAUD_RATE);
+#endif
+    active_voltage = VREG_VOLTAGE_DEFAULT;
+    active_name = "default (fallback)";
+}
+
+// Compare uncached flash reads against the cached image, twice
+static bool check_flash(void) {
+    const uint32_t *cached = (const uint32_t *)&__flash_binary_start;
+    const volatile uint32_t *uncached =
+        (const volatile uint32_t *)((uintptr_t)cached - XIP_BASE + XIP_NOCACHE_NOALLOC_BASE);
+
+    for (int pass = 0; pass < 2; pass++) {
+        for (uint32_t i = 0; i < CONFIG_PICONTROLLER_CLOCK_CHECK_FLASH_BYTES / 4; i++) {
+            if (uncached[i] != cached[i]) {
+                printf("Clock: flash mismatch at +0x%lx\n", (unsigned long)(i * 4));
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool clock_profile_check(void) {
+#if CONFIG_PICONTROLLER_CLOCK_PROFILE != CLOCK_PROFILE_DEFAULT
+    if (!applied) {
+        printf("Clock: %s profile (%lu kHz) not reachable\n", PROFILE_NAME, (unsigned long)PROFILE_KHZ);
+        active_name = "default (fallback)";
+    } else {
+        printf("Clock: %s profile is not validated on hardware yet\n", PROFILE_NAME);
+    }
+#endif
+
+    uint32_t expected_khz = clock_get_hz(clk_sys) / 1000;
+    uint32_t measured_khz = frequency_count_khz(CLOCKS_FC0_SRC_VALUE_CLK_SYS);
+    uint32_t error_khz = measured_khz > expected_khz ? measured_khz - expected_khz : expected_khz - measured_khz;
+    bool clock_ok = error_khz * 100 <= expected_khz * CONFIG_PICONTROLLER_CLOCK_CHECK_TOLERANCE_PCT;
+    bool flash_ok = check_flash();
+
+    printf("Clock: %s %s profile, clk_sys %lu kHz (measured %lu), vreg %d, flash div %d, cyw43 div %d\n",
+           CHIP_NAME, active_name, (unsigned long)expected_khz, (unsigned long)measured_khz,
+           (int)active_voltage, CONFIG_PICONTROLLER_FLASH_CLKDIV, CYW43_PIO_CLOCK_DIV_INT);
+
+    if (clock_ok && flash_ok) {
+        printf("Clock: self-check passed\n");
+        return true;
+    }
+
+    printf("Clock: self-check failed (clock %s, flash %s)\n", clock_ok ? "ok" : "off", flash_ok ? "ok" : "bad");
+    if (active_voltage != VREG_VOLTAGE_DEFAULT || expected_khz != SYS_CLK_KHZ) {
+        fall_back();
+        printf("Clock: running %lu kHz at default voltage\n", (unsigned long)(clock_get_hz(clk_sys) / 1000));
+    }
+    return false;
+}
+
+enum vreg_voltage clock_profile_voltage(void) {
+    return active_voltage;
+}
@@ -0,0 +1,159 @@
+/*
+ * Fast-path input report parsers for common controllers
+ *
+ * Each parser reads fixed offsets of one report layout and writes every
+ * field of the sample, so nothing from an earlier report leaks through.
+ * Face buttons are positional in bluepad32 terms (bottom = BUTTON_A,
+ * right = BUTTON_B, left = BUTTON_X, top = BUTTON_Y). Sticks are
+ * -512..511 with down and right positive, triggers 0..1023, gyro the raw
+ * sensor counts.
+ *
+ * Switch Pro pads stay on bluepad32's parser: their sticks are scaled by
+ * the factory calibration bluepad32 reads from the pad at connect, which
+ * is private to its parser. Verify against bluepad32 on real pads with
+ * CONFIG_PICONTROLLER_FAST_PARSE_VERIFY.
+ */
+
+#include "fast_parse.h"
+
+#include <string.h>
+
+#include <uni.h>
+
+// Hat switch (0 = up, clockwise, 8+ = released) to bluepad32 D-pad bits
+static const uint8_t hat_to_dpad[16] = {
+    DPAD_UP,
+    DPAD_UP | DPAD_RIGHT,
+    DPAD_RIGHT,
+    DPAD_DOWN | DPAD_RIGHT,
+    DPAD_DOWN,
+    DPAD_DOWN | DPAD_LEFT,
+    DPAD_LEFT,
+    DPAD_UP | DPAD_LEFT,
+};
+
+static inline int16_t get_i16(const uint8_t *p) {
+    return (int16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint16_t get_u16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+// DualShock 4 and DualSense share the button layout from the hat byte on
+static void parse_playstation_buttons(const uint8_t *b, raw_sample_t *sample) {
+    uint16_t buttons = 0;
+    buttons |= (b[0] & 0x10) ? BUTTON_X : 0;  // square
+    buttons |= (b[0] & 0x20) ? BUTTON_A : 0;  // cross
+    buttons |= (b[0] & 0x40) ? BUTTON_B : 0;  // circle
+    buttons |= (b[0] & 0x80) ? BUTTON_Y : 0;  // triangle
+    buttons |= (b[1] & 0x01) ? BUTTON_SHOULDER_L : 0;
+    buttons |= (b[1] & 0x02) ? BUTTON_SHOULDER_R : 0;
+    buttons |= (b[1] & 0x04) ? BUTTON_TRIGGER_L : 0;
+    buttons |= (b[1] & 0x08) ? BUTTON_TRIGGER_R : 0;
+    buttons |= (b[1] & 0x40) ? BUTTON_THUMB_L : 0;
+    buttons |= (b[1] & 0x80) ? BUTTON_THUMB_R : 0;
+    sample->buttons = buttons;
+
+    uint8_t misc = 0;
+    misc |= (b[1] & 0x10) ? MISC_BUTTON_BACK : 0;     // share / create
+    misc |= (b[1] & 0x20) ? MISC_BUTTON_HOME : 0;     // options
+    misc |= (b[2] & 0x01) ? MISC_BUTTON_SYSTEM : 0;   // PS
+    misc |= (b[2] & 0x02) ? MISC_BUTTON_CAPTURE : 0;  // touchpad click
+    sample->misc_buttons = misc;
+
+    sample->dpad = hat_to_dpad[b[0] & 0x0F];
+}
+
+static void parse_playstation_sticks(const uint8_t *s, uint8_t brake, uint8_t throttle, raw_sample_t *sample) {
+    for (int i = 0; i < STICK_AXIS_COUNT; i++) {
+        sample->axes[i] = (int16_t)((s[i] - 127) * 4);
+    }
+    sample->brake = (uint16_t)(brake * 4);
+    sample->throttle = (uint16_t)(throttle * 4);
+}
+
+// Offsets within the DualShock 4 input report body
+#define DS4_BODY 3
+#define DS4_BUTTONS 4
+#define DS4_BRAKE 7
+#define DS4_THROTTLE 8
+#define DS4_GYRO 12
+#define DS4_BODY_LEN 24
+
+bool fast_parse_ds4(const uint8_t *report, uint16_t len, raw_sample_t *sample) {
+    if (len < DS4_BODY + DS4_BODY_LEN || report[0] != 0x11) {
+        return false;
+    }
+
+    const uint8_t *r = report + DS4_BODY;
+    parse_playstation_buttons(r + DS4_BUTTONS, sample);
+    parse_playstation_sticks(r, r[DS4_BRAKE], r[DS4_THROTTLE], sample);
+    for (int i = 0; i < 3; i++) {
+        sample->gyro[i] = get_i16(r + DS4_GYRO + i * 2);
+    }
+    return true;
+}
+
+// Offsets within the DualSense input report body
+#define DS5_BODY 2
+#define DS5_BRAKE 4
+#define DS5_THROTTLE 5
+#define DS5_BUTTONS 7
+#define DS5_GYRO 15
+#define DS5_BODY_LEN 27
+
+bool fast_parse_ds5(const uint8_t *report, uint16_t len, raw_sample_t *sample) {
+    if (len < DS5_BODY + DS5_BODY_LEN || report[0] != 0x31) {
+        return false;
+    }
+
+    const uint8_t *r = report + DS5_BODY;
+    parse_playstation_buttons(r + DS5_BUTTONS, sample);
+    parse_playstation_sticks(r, r[DS5_BRAKE], r[DS5_THROTTLE], sample);
+    for (int i = 0; i < 3; i++) {
+        sample->gyro[i] = get_i16(r + DS5_GYRO + i * 2);
+    }
+    return true;
+}
+
+// Xbox Wireless report body: four 16-bit sticks, two 10-bit triggers,
+// hat (1 = up, 0 = released) and three button bytes
+#define XBOX_BODY_LEN 16
+
+bool fast_parse_xbox(const uint8_t *report, uint16_t len, raw_sample_t *sample) {
+    // Only the firmware 5.x layout; older firmware sends 16 bytes with the
+    // report ID included and a different button layout
+    if (len != XBOX_BODY_LEN + 1 || report[0] != 0x01) {
+        return false;
+    }
+    const uint8_t *r = report + 1;
+
+    for (int i = 0; i < STICK_AXIS_COUNT; i++) {
+        sample->axes[i] = (int16_t)((get_u16(r + i * 2) - 32768) / 64);
+    }
+    sample->brake = get_u16(r + 8) & 0x3FF;
+    sample->throttle = get_u16(r + 10) & 0x3FF;
+    sample->dpad = r[12] ? hat_to_dpad[(r[12] - 1) & 0x0F] : 0;
+
+    uint16_t buttons = 0;
+    buttons |= (r[13] & 0x01) ? BUTTON_A : 0;
+    buttons |= (r[13] & 0x02) ? BUTTON_B : 0;
+    buttons |= (r[13] & 0x08) ? BUTTON_X : 0;
+    buttons |= (r[13] & 0x10) ? BUTTON_Y : 0;
+    buttons |= (r[13] & 0x40) ? BUTTON_SHOULDER_L : 0;
+    buttons |= (r[13] & 0x80) ? BUTTON_SHOULDER_R : 0;
+    buttons |= (r[14] & 0x20) ? BUTTON_THUMB_L : 0;
+    buttons |= (r[14] & 0x40) ? BUTTON_THUMB_R : 0;
+    sample->buttons = buttons;
+
+    uint8_t misc = 0;
+    misc |= (r[14] & 0x04) ? MISC_BUTTON_BACK : 0;     // view
+    misc |= (r[14] & 0x08) ? MISC_BUTTON_HOME : 0;     // menu
+    misc |= (r[14] & 0x10) ? MISC_BUTTON_SYSTEM : 0;   // Xbox
+    misc |= (r[15] & 0x01) ? MISC_BUTTON_CAPTURE : 0;  // share
+    sample->misc_buttons = misc;
+
+    memset(sample->gyro, 0, sizeof(sample->gyro));
+    return true;
+}
@@ -0,0 +1,114 @@
+/*
+ * Idle clock and voltage governor (runs on Core 0)
+ *
+ * Idle means no controller slot is active, or USB is suspended, for
+ * CONFIG_PICONTROLLER_GOVERNOR_IDLE_DELAY_MS. While idle the system clock
+ * runs from PLL_USB at 48 MHz (PLL_SYS is powered down), the core
+ * voltage is lowered, and Core 0 waits for an event between loop
+ * iterations instead of spinning. Bluetooth keeps scanning and
+ * reconnecting on Core 1 at the lower clock.
+ *
+ * Waking up is bounded: a report from Core 1 (FIFO push, SEV) or a USB
+ * interrupt ends the wait at once, the next poll sees the active slot
+ * or the resumed bus, and the voltage and PLL_SYS are restored. Each
+ * wake-up is timed and logged together with the worst case so far.
+ *
+ * The CYW43 SPI on Core 1 runs from a PIO clocked by clk_sys. Both
+ * switches hold the CYW43 async context lock, which Core 1 holds for
+ * every bus transfer, so no transfer sees its clock change. The PIO
+ * divider is fixed at build time (CYW43_PIO_CLOCK_DIV_INT) and is left
+ * alone: at 48 MHz it only slows the bus down, and the full-speed rate
+ * is the one the clock profile chose it for.
+ *
+ * Not validated: the lock handover between the cores, the idle current
+ * and the wake-up latency have not been checked on hardware. Off by
+ * default until they are.
+ */
+
+#include "governor.h"
+
+#ifdef CONFIG_PICONTROLLER_GOVERNOR
+
+#include <stdio.h>
+
+#include <pico/cyw43_arch.h>
+#include <pico/stdlib.h>
+#include <pico/time.h>
+#include <hardware/clocks.h>
+#include <hardware/uart.h>
+#include <hardware/vreg.h>
+
+#include "clock_profile.h"
+#include "report.h"
+
+static uint32_t full_khz;
+static bool idle;
+static uint32_t last_busy_us;
+static uint32_t idle_since_us;
+static uint32_t wake_max_us;
+
+static void enter_idle(uint32_t now) {
+    // Clock down first, then voltage (set_sys_clock_48mhz() re-inits the UART)
+    async_context_t *context = cyw43_arch_async_context();
+    async_context_acquire_lock_blocking(context);
+    set_sys_clock_48mhz();
+    vreg_set_voltage(CONFIG_PICONTROLLER_GOVERNOR_IDLE_VOLTAGE);
+    async_context_release_lock(context);
+
+    idle = true;
+    idle_since_us = now;
+    printf("Governor: idle at 48 MHz\n");
+}
+
+static void leave_idle(uint32_t now) {
+    // Voltage up first, then clock
+    async_context_t *context = cyw43_arch_async_context();
+    async_context_acquire_lock_blocking(context);
+    vreg_set_voltage(clock_profile_voltage());
+    busy_wait_us_32(CONFIG_PICONTROLLER_GOVERNOR_VREG_SETTLE_US);
+    set_sys_clock_khz(full_khz, true);
+    async_context_release_lock(context);
+#if defined(LIB_PICO_STDIO_UART) && defined(uart_default)
+    // clk_peri follows clk_sys; unlike the 48 MHz switch this leaves the
+    // UART divider alone
+    uart_set_baudrate(uart_default, PICO_DEFAULT_UART_BAUD_RATE);
+#endif
+
+    idle = false;
+    uint32_t wake_us = time_us_32() - now;
+    if (wake_us > wake_max_us) {
+        wake_max_us = wake_us;
+    }
+    printf("Governor: full speed in %lu us (max %lu us) after %lu s idle\n",
+           (unsigned long)wake_us, (unsigned long)wake_max_us,
+           (unsigned long)((now - idle_since_us) / 1000000));
+}
+
+void governor_init(void) {
+    full_khz = clock_get_hz(clk_sys) / 1000;
+    last_busy_us = time_us_32();
+}
+
+void governor_poll(bool usb_suspended) {
+    uint32_t now = time_us_32();
+
+    if (!usb_suspended && get_global_gamepad_any_active()) {
+        last_busy_us = now;
+        if (idle) {
+            leave_idle(now);
+        }
+        return;
+    }
+
+    if (!idle) {
+        if (now - last_busy_us < CONFIG_PICONTROLLER_GOVERNOR_IDLE_DELAY_MS * 1000u) {
+            return;
+        }
+        enter_idle(now);
+    }
+
+    // Reports from Core 1 and USB interrupts end the wait early
+    best_effort_wfe_or_timeout(make_timeout_time_us(CONFIG_PICONTROLLER_GOVERNOR_IDLE_POLL_US));
+}
+
+#endif /* CONFIG_PICONTROLLER_GOVERNOR */
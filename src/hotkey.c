@@ -0,0 +1,115 @@
+/*
+ * Chorded hotkey layer
+ *
+ * Only the transitions are handled here; hotkey_layer_apply() skips the
+ * call while the layer is idle and the modifier is up, and only records
+ * the buttons. Edges are taken against the previous report, so a key
+ * pressed together with the modifier fires, while one already held when
+ * the modifier goes down does not.
+ */
+
+#include "hotkey.h"
+
+// Replayed length of a modifier tap (frames)
+#define MODIFIER_TAP_FRAMES 8
+
+// Holding the modifier this long without a chord passes it through (frames)
+#define MODIFIER_PASSTHROUGH_FRAMES 500
+
+void hotkey_layer_init(hotkey_layer_t *layer, uint16_t modifier, bool hold_modifier,
+                       const hotkey_t *keys, uint8_t key_count) {
+    layer->modifier = modifier;
+    layer->hold_modifier = hold_modifier;
+    layer->keys = keys;
+    layer->key_count = key_count;
+    layer->state = HOTKEY_IDLE;
+    layer->state_frame = 0;
+    layer->previous_buttons = 0;
+
+    layer->key_mask = 0;
+    for (uint8_t i = 0; i < key_count; i++) {
+        layer->key_mask |= keys[i].button;
+    }
+}
+
+static void fire_keys(const hotkey_layer_t *layer, uint16_t pressed, uint32_t frame) {
+    for (uint8_t i = 0; i < layer->key_count; i++) {
+        if (pressed & layer->keys[i].button) {
+            layer->keys[i].action(layer->keys[i].arg, frame);
+        }
+    }
+}
+
+void hotkey_layer_update(hotkey_layer_t *layer, SwitchOutReport *report, uint32_t frame) {
+    uint16_t buttons = report->buttons;
+    uint16_t pressed = buttons & ~layer->previous_buttons;
+    bool held = (buttons & layer->modifier) != 0;
+    layer->previous_buttons = buttons;
+
+    switch (layer->state) {
+        case HOTKEY_IDLE:
+            layer->state_frame = frame;
+            if (pressed & layer->key_mask) {
+                // Modifier and key in the same report
+                fire_keys(layer, pressed, frame);
+                layer->state = HOTKEY_CHORD;
+                break;
+            }
+            layer->state = HOTKEY_PENDING;
+            break;
+
+        case HOTKEY_PENDING:
+            if (!held) {
+                // Released on its own: replay it as a tap if it was held back
+                layer->state = layer->hold_modifier ? HOTKEY_TAP : HOTKEY_IDLE;
+                layer->state_frame = frame;
+                break;
+            }
+            if (pressed & layer->key_mask) {
+                fire_keys(layer, pressed, frame);
+                layer->state = HOTKEY_CHORD;
+                break;
+            }
+            if (frame - layer->state_frame >= MODIFIER_PASSTHROUGH_FRAMES) {
+                layer->state = HOTKEY_PASSTHROUGH;
+            }
+            break;
+
+        case HOTKEY_CHORD:
+            if (!held) {
+                layer->state = HOTKEY_IDLE;
+            } else if (pressed & layer->key_mask) {
+                fire_keys(layer, pressed, frame);
+            }
+            break;
+
+        case HOTKEY_PASSTHROUGH:
+            if (!held) {
+                layer->state = HOTKEY_IDLE;
+            }
+            break;
+
+        case HOTKEY_TAP:
+            if (frame - layer->state_frame >= MODIFIER_TAP_FRAMES) {
+                layer->state = held ? HOTKEY_PENDING : HOTKEY_IDLE;
+                layer->state_frame = frame;
+            }
+            break;
+    }
+
+    switch (layer->state) {
+        case HOTKEY_PENDING:
+            if (layer->hold_modifier) {
+                report->buttons &= ~layer->modifier;
+            }
+            break;
+        case HOTKEY_CHORD:
+            report->buttons &= ~(layer->modifier | layer->key_mask);
+            break;
+        case HOTKEY_TAP:
+            report->buttons |= layer->modifier;
+            break;
+        default:
+            break;
+    }
+}
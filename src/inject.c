@@ -0,0 +1,152 @@
+/*
+ * Virtual controller input over the debug UART
+ *
+ * Bytes arrive one at a time from BTstack stdin. The parser hunts for the
+ * two sync bytes, collects a full frame and checks its checksum. On a
+ * mismatch it resumes from the next sync pair inside the rejected bytes,
+ * so a partial frame followed by a good one costs only the partial one.
+ * The 8-bit checksum still passes about 1 in 256 corrupt frames.
+ *
+ * Counters for accepted frames, checksum errors and lost frames are
+ * logged periodically to judge link saturation. Lost frames are counted
+ * from forward sequence gaps of up to INJECT_LOST_WINDOW frames; a larger
+ * jump is taken as a corrupt sequence number that got past the checksum
+ * and only moves the sequence on, so the frames after it that do arrive
+ * are not counted.
+ */
+
+#include "inject.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#include <btstack_stdin.h>
+
+#include "sdkconfig.h"
+
+// Log statistics every N accepted frames
+#define INJECT_LOG_INTERVAL 1000
+
+// Largest sequence gap counted as lost frames
+#define INJECT_LOST_WINDOW 32
+
+static inject_handler_t inject_handler;
+
+static uint8_t frame[INJECT_FRAME_SIZE];
+static uint8_t frame_len;
+
+static uint8_t last_sequence;
+static bool have_sequence;
+static uint32_t frames_ok;
+static uint32_t frames_bad;
+static uint32_t frames_lost;
+
+static int16_t get_i16(const uint8_t *p) {
+    return (int16_t)(p[0] | (p[1] << 8));
+}
+
+static uint16_t get_u16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+// Drop a rejected frame up to the next sync pair in it, keeping the rest
+static void resync(void) {
+    uint8_t start = 1;
+    while (start < INJECT_FRAME_SIZE &&
+           !(frame[start] == INJECT_SYNC0 && (start + 1 == INJECT_FRAME_SIZE || frame[start + 1] == INJECT_SYNC1))) {
+        start++;
+    }
+    frame_len = INJECT_FRAME_SIZE - start;
+    memmove(frame, &frame[start], frame_len);
+}
+
+// Decode a full frame; false if the checksum does not match
+static bool decode_frame(void) {
+    uint8_t sum = 0;
+    for (int i = 2; i < INJECT_FRAME_SIZE; i++) {
+        sum += frame[i];
+    }
+    if (sum != 0) {
+        frames_bad++;
+        return false;
+    }
+
+    uint8_t slot = frame[2] & 0x0F;
+    uint8_t flags = frame[2] & 0xF0;
+    uint8_t sequence = frame[3];
+
+    if (have_sequence) {
+        uint8_t gap = (uint8_t)(sequence - last_sequence - 1);
+        if (gap <= INJECT_LOST_WINDOW) {
+            frames_lost += gap;
+        }
+    }
+    last_sequence = sequence;
+    have_sequence = true;
+
+    if (++frames_ok % INJECT_LOG_INTERVAL == 0) {
+        logi("inject: %lu frames, %lu bad, %lu lost\n",
+             (unsigned long)frames_ok, (unsigned long)frames_bad, (unsigned long)frames_lost);
+    }
+
+    if (slot >= CONFIG_PICONTROLLER_INJECT_SLOTS) {
+        return true;
+    }
+    if (flags & INJECT_FLAG_DISCONNECT) {
+        have_sequence = false;
+        inject_handler(slot, NULL);
+        return true;
+    }
+
+    uni_gamepad_t gp;
+    memset(&gp, 0, sizeof(gp));
+    gp.buttons = get_u16(&frame[4]);
+    gp.dpad = frame[6];
+    gp.misc_buttons = frame[7];
+    gp.axis_x = get_i16(&frame[8]);
+    gp.axis_y = get_i16(&frame[10]);
+    gp.axis_rx = get_i16(&frame[12]);
+    gp.axis_ry = get_i16(&frame[14]);
+    gp.brake = get_u16(&frame[16]);
+    gp.throttle = get_u16(&frame[18]);
+
+    inject_handler(slot, &gp);
+    return true;
+}
+
+static void stdin_handler(char c) {
+    uint8_t byte = (uint8_t)c;
+
+    // Hunt for the sync pair; a repeated first sync byte restarts it
+    if (frame_len == 0) {
+        if (byte == INJECT_SYNC0) {
+            frame[frame_len++] = byte;
+        }
+        return;
+    }
+    if (frame_len == 1) {
+        if (byte == INJECT_SYNC1) {
+            frame[frame_len++] = byte;
+        } else if (byte != INJECT_SYNC0) {
+            frame_len = 0;
+        }
+        return;
+    }
+
+    frame[frame_len++] = byte;
+    if (frame_len == INJECT_FRAME_SIZE) {
+        if (decode_frame()) {
+            frame_len = 0;
+        } else {
+            resync();
+        }
+    }
+}
+
+void inject_start(inject_handler_t handler) {
+    inject_handler = handler;
+    frame_len = 0;
+    have_sequence = false;
+    btstack_stdin_setup(stdin_handler);
+    logi("inject: listening for virtual controller frames on stdin\n");
+}
@@ -0,0 +1,238 @@
+/*
+ * Keyboard and mouse to Switch controller translation
+ *
+ * Default layout:
+ *   WASD        left stick          Arrows      D-pad
+ *   Space       B (jump)            E / F       A / X
+ *   R           Y                   Q / 1 / 3   L3 / L / R
+ *   Shift       L3 (sprint)         Ctrl        ZL
+ *   Tab         MINUS               Enter/Esc   PLUS
+ *   H           HOME                F12         CAPTURE
+ *   Mouse left  ZR                  Mouse right ZL
+ *   Mouse mid   R3                  Mouse move  right stick
+ *
+ * Mouse motion crosses cores through a pair of running totals. Core 1 is
+ * the only writer and just adds each event's delta (a plain 32-bit store,
+ * atomic on Cortex-M0+); Core 0 remembers how much it has already drained
+ * and takes the difference once per frame. Nothing is locked and no motion
+ * is lost, even when a 1 kHz mouse reports between frames.
+ */
+
+#include "kbm.h"
+
+#include "sdkconfig.h"
+
+// HID keyboard usages (HID Usage Tables, page 0x07)
+#define KEY_A      0x04
+#define KEY_D      0x07
+#define KEY_E      0x08
+#define KEY_F      0x09
+#define KEY_H      0x0B
+#define KEY_Q      0x14
+#define KEY_R      0x15
+#define KEY_S      0x16
+#define KEY_W      0x1A
+#define KEY_1      0x1E
+#define KEY_3      0x20
+#define KEY_ENTER  0x28
+#define KEY_ESCAPE 0x29
+#define KEY_TAB    0x2B
+#define KEY_SPACE  0x2C
+#define KEY_F12    0x45
+#define KEY_RIGHT  0x4F
+#define KEY_LEFT   0x50
+#define KEY_DOWN   0x51
+#define KEY_UP     0x52
+
+// HID keyboard modifier bits
+#define MOD_CTRL  (0x01 | 0x10)
+#define MOD_SHIFT (0x02 | 0x20)
+
+// bluepad32 mouse button bits
+#define MOUSE_LEFT   (1U << 0)
+#define MOUSE_RIGHT  (1U << 1)
+#define MOUSE_MIDDLE (1U << 2)
+
+// Direction bits
+#define DIR_UP    (1U << 0)
+#define DIR_DOWN  (1U << 1)
+#define DIR_LEFT  (1U << 2)
+#define DIR_RIGHT (1U << 3)
+
+typedef struct {
+    uint16_t buttons;
+    uint8_t stick;  // Left stick direction bits
+    uint8_t hat;    // D-pad direction bits
+} kbm_key_t;
+
+static const kbm_key_t keymap[256] = {
+    [KEY_W]      = { .stick = DIR_UP },
+    [KEY_S]      = { .stick = DIR_DOWN },
+    [KEY_A]      = { .stick = DIR_LEFT },
+    [KEY_D]      = { .stick = DIR_RIGHT },
+    [KEY_UP]     = { .hat = DIR_UP },
+    [KEY_DOWN]   = { .hat = DIR_DOWN },
+    [KEY_LEFT]   = { .hat = DIR_LEFT },
+    [KEY_RIGHT]  = { .hat = DIR_RIGHT },
+    [KEY_SPACE]  = { .buttons = SWITCH_MASK_B },
+    [KEY_E]      = { .buttons = SWITCH_MASK_A },
+    [KEY_F]      = { .buttons = SWITCH_MASK_X },
+    [KEY_R]      = { .buttons = SWITCH_MASK_Y },
+    [KEY_Q]      = { .buttons = SWITCH_MASK_L3 },
+    [KEY_1]      = { .buttons = SWITCH_MASK_L },
+    [KEY_3]      = { .buttons = SWITCH_MASK_R },
+    [KEY_TAB]    = { .buttons = SWITCH_MASK_MINUS },
+    [KEY_ENTER]  = { .buttons = SWITCH_MASK_PLUS },
+    [KEY_ESCAPE] = { .buttons = SWITCH_MASK_PLUS },
+    [KEY_H]      = { .buttons = SWITCH_MASK_HOME },
+    [KEY_F12]    = { .buttons = SWITCH_MASK_CAPTURE },
+};
+
+// Direction bits (up, down, left, right) to Switch hat
+static const uint8_t hat_from_dir[16] = {
+    SWITCH_HAT_NOTHING,   // none
+    SWITCH_HAT_UP,        // U
+    SWITCH_HAT_DOWN,      // D
+    SWITCH_HAT_NOTHING,   // U+D
+    SWITCH_HAT_LEFT,      // L
+    SWITCH_HAT_UPLEFT,    // U+L
+    SWITCH_HAT_DOWNLEFT,  // D+L
+    SWITCH_HAT_LEFT,      // U+D+L
+    SWITCH_HAT_RIGHT,     // R
+    SWITCH_HAT_UPRIGHT,   // U+R
+    SWITCH_HAT_DOWNRIGHT, // D+R
+    SWITCH_HAT_RIGHT,     // U+D+R
+    SWITCH_HAT_NOTHING,   // L+R
+    SWITCH_HAT_UP,        // U+L+R
+    SWITCH_HAT_DOWN,      // D+L+R
+    SWITCH_HAT_NOTHING,   // all
+};
+
+// Mouse motion totals (written by Core 1 only)
+static volatile uint32_t mouse_total_x;
+static volatile uint32_t mouse_total_y;
+
+// Core 0 state
+static uint32_t mouse_drained_x;
+static uint32_t mouse_drained_y;
+static int32_t mouse_stick_q8[2];
+
+static uint8_t dir_to_axis(uint8_t dirs, uint8_t neg, uint8_t pos) {
+    bool n = (dirs & neg) != 0;
+    bool p = (dirs & pos) != 0;
+    if (n == p) {
+        return SWITCH_JOYSTICK_MID;
+    }
+    return n ? SWITCH_JOYSTICK_MIN : SWITCH_JOYSTICK_MAX;
+}
+
+void kbm_fill_keyboard_report(const uni_keyboard_t *kb, SwitchOutReport *report) {
+    uint16_t buttons = 0;
+    uint8_t stick = 0;
+    uint8_t hat = 0;
+
+    for (int i = 0; i < UNI_KEYBOARD_PRESSED_KEYS_MAX; i++) {
+        const kbm_key_t *key = &keymap[kb->pressed_keys[i]];
+        buttons |= key->buttons;
+        stick |= key->stick;
+        hat |= key->hat;
+    }
+
+    if (kb->modifiers & MOD_SHIFT) {
+        buttons |= SWITCH_MASK_L3;
+    }
+    if (kb->modifiers & MOD_CTRL) {
+        buttons |= SWITCH_MASK_ZL;
+    }
+
+    report->buttons = buttons;
+    report->hat = hat_from_dir[hat & 0x0F];
+    report->lx = dir_to_axis(stick, DIR_LEFT, DIR_RIGHT);
+    report->ly = dir_to_axis(stick, DIR_UP, DIR_DOWN);
+    report->rx = SWITCH_JOYSTICK_MID;
+    report->ry = SWITCH_JOYSTICK_MID;
+}
+
+void kbm_fill_mouse_report(const uni_mouse_t *mouse, SwitchOutReport *report) {
+    // Single writer: a plain read-modify-write is safe
+    mouse_total_x += (uint32_t)mouse->delta_x;
+    mouse_total_y += (uint32_t)mouse->delta_y;
+
+    report->buttons = 0;
+    if (mouse->buttons & MOUSE_LEFT) {
+        report->buttons |= SWITCH_MASK_ZR;
+    }
+    if (mouse->buttons & MOUSE_RIGHT) {
+        report->buttons |= SWITCH_MASK_ZL;
+    }
+    if (mouse->buttons & MOUSE_MIDDLE) {
+        report->buttons |= SWITCH_MASK_R3;
+    }
+    report->hat = SWITCH_HAT_NOTHING;
+    report->lx = SWITCH_JOYSTICK_MID;
+    report->ly = SWITCH_JOYSTICK_MID;
+    report->rx = SWITCH_JOYSTICK_MID;
+    report->ry = SWITCH_JOYSTICK_MID;
+}
+
+// One frame of the stick model: exponential approach to the target rate
+static int32_t mouse_axis_step(int32_t stick_q8, int32_t delta, uint32_t frames_elapsed) {
+    int32_t target_q8 = delta * CONFIG_PICONTROLLER_KBM_MOUSE_SENSITIVITY * 256;
+    if (frames_elapsed > 1) {
+        // Spread a multi-frame delta over the frames it covers
+        target_q8 /= (int32_t)frames_elapsed;
+    }
+    if (target_q8 > 127 * 256) {
+        target_q8 = 127 * 256;
+    } else if (target_q8 < -127 * 256) {
+        target_q8 = -127 * 256;
+    }
+
+    stick_q8 += (target_q8 - stick_q8) >> CONFIG_PICONTROLLER_KBM_MOUSE_DECAY_SHIFT;
+
+    // Settle to exactly zero instead of creeping
+    if (target_q8 == 0 && stick_q8 > -128 && stick_q8 < 128) {
+        stick_q8 = 0;
+    }
+    return stick_q8;
+}
+
+void kbm_mouse_frame(uint32_t frames_elapsed) {
+    if (frames_elapsed == 0) {
+        return;
+    }
+
+    uint32_t total_x = mouse_total_x;
+    uint32_t total_y = mouse_total_y;
+    int32_t dx = (int32_t)(total_x - mouse_drained_x);
+    int32_t dy = (int32_t)(total_y - mouse_drained_y);
+    mouse_drained_x = total_x;
+    mouse_drained_y = total_y;
+
+    mouse_stick_q8[0] = mouse_axis_step(mouse_stick_q8[0], dx, frames_elapsed);
+    mouse_stick_q8[1] = mouse_axis_step(mouse_stick_q8[1], dy, frames_elapsed);
+}
+
+// Curve: skip the game's inner deadzone, then scale linearly to full range
+static uint8_t mouse_axis_output(int32_t stick_q8) {
+    int32_t mag = (stick_q8 < 0 ? -stick_q8 : stick_q8) >> 8;
+    if (mag == 0) {
+        return SWITCH_JOYSTICK_MID;
+    }
+
+    int32_t out = CONFIG_PICONTROLLER_KBM_MOUSE_ANTI_DEADZONE +
+                  (mag * (127 - CONFIG_PICONTROLLER_KBM_MOUSE_ANTI_DEADZONE)) / 127;
+    if (out > 127) {
+        out = 127;
+    }
+    return (uint8_t)(SWITCH_JOYSTICK_MID + (stick_q8 < 0 ? -out : out));
+}
+
+void kbm_mouse_apply(SwitchOutReport *report) {
+    if (mouse_stick_q8[0] == 0 && mouse_stick_q8[1] == 0) {
+        return;
+    }
+
+    report->rx = mouse_axis_output(mouse_stick_q8[0]);
+    report->ry = mouse_axis_output(mouse_stick_q8[1]);
+}
@@ -0,0 +1,376 @@
+/*
+ * Bluetooth link health monitor (runs on Core 1)
+ *
+ * Every controller report is timestamped on arrival. Intervals feed a
+ * running average, a histogram and a gap counter (intervals longer than
+ * CONFIG_PICONTROLLER_LINK_HEALTH_GAP_MS). RSSI and, on BR/EDR links, the
+ * controller's link quality (its retransmission/bit error estimate) are
+ * polled with one HCI command per link per evaluation window, BR/EDR links
+ * alternating between the two. Queries go out one at a time, spaced by
+ * POLL_SPACING_MS and only when the controller can take a command, so
+ * they never compete with connection traffic for the command slot.
+ *
+ * A window is degraded when a pad that streams reports had too many gaps,
+ * or when RSSI or link quality fell below their thresholds. Pads that only
+ * report on change are judged by RSSI and link quality alone. On the first
+ * degraded window the link is renegotiated (sniff mode exit on BR/EDR, a
+ * short connection interval on LE). Optionally, if it stays degraded it
+ * is dropped so the controller reconnects with its stored link key, at
+ * most once per cooldown period.
+ *
+ * BR/EDR RSSI is relative to the radio's golden receive range: 0 is fine,
+ * negative values mean a weak signal. LE RSSI is in dBm and only logged.
+ */
+
+#include "link_health.h"
+
+#ifdef CONFIG_PICONTROLLER_LINK_HEALTH
+
+#include <stdbool.h>
+#include <string.h>
+
+#include <btstack.h>
+#include <pico/time.h>
+
+#define LINK_SLOTS CONFIG_BLUEPAD32_MAX_DEVICES
+
+// HCI Read Link Quality (Status Parameters), not wrapped by BTstack's GAP
+#define READ_LINK_QUALITY_OPCODE HCI_OPCODE(OGF_STATUS_PARAMETERS, 0x03)
+static const hci_cmd_t read_link_quality = { READ_LINK_QUALITY_OPCODE, "H" };
+
+// Time between two link queries
+#define POLL_SPACING_MS 10
+
+// HCI_EVENT_MODE_CHANGE current mode
+#define LINK_MODE_SNIFF 2
+
+// Interval histogram bucket limits in ms (last bucket is everything above)
+static const uint16_t histogram_ms[] = { 10, 20, 50, 100 };
+#define HISTOGRAM_BUCKETS (sizeof(histogram_ms) / sizeof(histogram_ms[0]) + 1)
+
+typedef struct {
+    bool connected;
+    bool le;
+    hci_con_handle_t handle;
+    uint32_t connected_us;
+
+    uint32_t last_us;          // last report arrival (0 = none yet)
+    uint32_t interval_avg_us;  // running average, weight 1/16
+
+    // Current evaluation window
+    uint16_t window_reports;
+    uint16_t window_gaps;
+
+    // Current log period
+    uint32_t period_max_us;
+    uint32_t histogram[HISTOGRAM_BUCKETS];
+
+    // Since connect
+    uint32_t reports;
+    uint32_t gaps;
+    uint32_t degraded_windows;
+
+    int8_t rssi;
+    bool rssi_valid;
+    uint8_t link_quality;
+    bool link_quality_valid;
+    uint16_t sniff_slots;  // sniff interval in 0.625 ms slots, 0 = active mode
+    bool poll_due;         // this window's query not sent yet
+    bool poll_quality;     // BR/EDR: next query is link quality, not RSSI
+
+    uint8_t bad_streak;    // consecutive degraded windows
+} link_t;
+
+static link_t links[LINK_SLOTS];
+
+// Outlive the connection so a drop can be timed and rate limited
+static uint32_t dropped_us[LINK_SLOTS];
+
+static btstack_packet_callback_registration_t hci_event_callback;
+static btstack_timer_source_t window_timer;
+static btstack_timer_source_t poll_timer;
+static bool poll_running;
+static uint8_t poll_next;
+static uint8_t windows_since_log;
+
+static link_t *find_link(hci_con_handle_t handle) {
+    for (int i = 0; i < LINK_SLOTS; i++) {
+        if (links[i].connected && links[i].handle == handle) {
+            return &links[i];
+        }
+    }
+    return NULL;
+}
+
+static void log_link(int idx, const link_t *l, const char *reason) {
+    logi("link: pad %d %s%s rssi %d lq %u sniff %u avg %lu.%lu ms max %lu ms gaps %u (%lu) hist %lu/%lu/%lu/%lu/%lu\n",
+         idx, l->le ? "le" : "acl", reason,
+         l->rssi_valid ? l->rssi : 0, l->link_quality_valid ? l->link_quality : 0, l->sniff_slots,
+         (unsigned long)(l->interval_avg_us / 1000), (unsigned long)(l->interval_avg_us % 1000 / 100),
+         (unsigned long)(l->period_max_us / 1000), l->window_gaps, (unsigned long)l->gaps,
+         (unsigned long)l->histogram[0], (unsigned long)l->histogram[1], (unsigned long)l->histogram[2],
+         (unsigned long)l->histogram[3], (unsigned long)l->histogram[4]);
+}
+
+// First response to a degraded link: ask for a faster schedule
+static void renegotiate(int idx, link_t *l) {
+    if (l->le) {
+        gap_update_connection_parameters(l->handle, CONFIG_PICONTROLLER_LINK_HEALTH_LE_INTERVAL,
+                                         CONFIG_PICONTROLLER_LINK_HEALTH_LE_INTERVAL, 0,
+                                         CONFIG_PICONTROLLER_LINK_HEALTH_LE_TIMEOUT);
+        logi("link: pad %d requesting %u x 1.25 ms connection interval\n", idx,
+             CONFIG_PICONTROLLER_LINK_HEALTH_LE_INTERVAL);
+    } else if (l->sniff_slots != 0) {
+        gap_sniff_mode_exit(l->handle);
+        logi("link: pad %d leaving sniff mode (%u slots)\n", idx, l->sniff_slots);
+    } else {
+        logi("link: pad %d degraded in active mode, nothing to renegotiate\n", idx);
+    }
+}
+
+static void degraded(int idx, link_t *l, uint32_t now) {
+    l->degraded_windows++;
+    l->bad_streak++;
+    if (l->bad_streak == 1) {
+        renegotiate(idx, l);
+        return;
+    }
+
+#if CONFIG_PICONTROLLER_LINK_HEALTH_RECONNECT_WINDOWS > 0
+    if (l->bad_streak < CONFIG_PICONTROLLER_LINK_HEALTH_RECONNECT_WINDOWS) {
+        return;
+    }
+    if (dropped_us[idx] != 0 &&
+        now - dropped_us[idx] < CONFIG_PICONTROLLER_LINK_HEALTH_RECONNECT_COOLDOWN_MS * 1000u) {
+        return;
+    }
+    logi("link: pad %d degraded for %u windows, dropping link to reconnect\n", idx, l->bad_streak);
+    dropped_us[idx] = now | 1;
+    gap_disconnect(l->handle);
+#else
+    (void)now;
+#endif
+}
+
+static void evaluate(int idx, link_t *l, uint32_t now) {
+    bool streaming = l->window_reports >= CONFIG_PICONTROLLER_LINK_HEALTH_MIN_REPORTS;
+    const char *reason = NULL;
+
+    if (streaming && l->window_gaps >= CONFIG_PICONTROLLER_LINK_HEALTH_GAP_LIMIT) {
+        reason = " gaps";
+    } else if (!l->le && l->rssi_valid && l->rssi < CONFIG_PICONTROLLER_LINK_HEALTH_RSSI_MIN) {
+        reason = " weak";
+#if CONFIG_PICONTROLLER_LINK_HEALTH_LINK_QUALITY_MIN > 0
+    } else if (!l->le && l->link_quality_valid &&
+               l->link_quality < CONFIG_PICONTROLLER_LINK_HEALTH_LINK_QUALITY_MIN) {
+        reason = " noisy";
+#endif
+    }
+
+    if (reason) {
+        log_link(idx, l, reason);
+        degraded(idx, l, now);
+    } else {
+        l->bad_streak = 0;
+    }
+}
+
+// Send one due query, then come back after POLL_SPACING_MS until none is left
+static void poll_handler(btstack_timer_source_t *ts) {
+    int idx = -1;
+    for (int n = 0; n < LINK_SLOTS; n++) {
+        int i = (poll_next + n) % LINK_SLOTS;
+        if (links[i].connected && links[i].poll_due) {
+            idx = i;
+            break;
+        }
+    }
+    if (idx < 0) {
+        poll_running = false;
+        return;
+    }
+
+    // A busy command slot only delays the query, the link keeps its turn
+    if (hci_can_send_command_packet_now()) {
+        link_t *l = &links[idx];
+        if (!l->le && l->poll_quality) {
+            hci_send_cmd(&read_link_quality, l->handle);
+        } else {
+            gap_read_rssi(l->handle);
+        }
+        l->poll_quality = !l->le && !l->poll_quality;
+        l->poll_due = false;
+        poll_next = (uint8_t)((idx + 1) % LINK_SLOTS);
+    }
+
+    btstack_run_loop_set_timer(ts, POLL_SPACING_MS);
+    btstack_run_loop_add_timer(ts);
+}
+
+static void window_handler(btstack_timer_source_t *ts) {
+    uint32_t now = time_us_32();
+    bool log_period = ++windows_since_log >= CONFIG_PICONTROLLER_LINK_HEALTH_LOG_WINDOWS;
+    if (log_period) {
+        windows_since_log = 0;
+    }
+
+    for (int i = 0; i < LINK_SLOTS; i++) {
+        link_t *l = &links[i];
+        if (!l->connected) {
+            continue;
+        }
+
+        evaluate(i, l, now);
+        if (log_period) {
+            log_link(i, l, "");
+            l->period_max_us = 0;
+            memset(l->histogram, 0, sizeof(l->histogram));
+        }
+        l->window_reports = 0;
+        l->window_gaps = 0;
+
+        // A query still waiting from the last window is simply kept
+        l->poll_due = true;
+        if (!poll_running) {
+            poll_running = true;
+            btstack_run_loop_set_timer(&poll_timer, 0);
+            btstack_run_loop_add_timer(&poll_timer);
+        }
+    }
+
+    btstack_run_loop_set_timer(ts, CONFIG_PICONTROLLER_LINK_HEALTH_WINDOW_MS);
+    btstack_run_loop_add_timer(ts);
+}
+
+static void hci_event_handler(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size) {
+    UNUSED(channel);
+    UNUSED(size);
+
+    if (packet_type != HCI_EVENT_PACKET) {
+        return;
+    }
+
+    link_t *l;
+    switch (hci_event_packet_get_type(packet)) {
+        case GAP_EVENT_RSSI_MEASUREMENT:
+            l = find_link(gap_event_rssi_measurement_get_con_handle(packet));
+            if (l) {
+                l->rssi = (int8_t)gap_event_rssi_measurement_get_rssi(packet);
+                l->rssi_valid = true;
+            }
+            break;
+
+        case HCI_EVENT_MODE_CHANGE:
+            if (hci_event_mode_change_get_status(packet) != ERROR_CODE_SUCCESS) {
+                break;
+            }
+            l = find_link(hci_event_mode_change_get_handle(packet));
+            if (l) {
+                l->sniff_slots = hci_event_mode_change_get_mode(packet) == LINK_MODE_SNIFF
+                                     ? hci_event_mode_change_get_interval(packet)
+                                     : 0;
+            }
+            break;
+
+        case HCI_EVENT_COMMAND_COMPLETE:
+            if (hci_event_command_complete_get_command_opcode(packet) == READ_LINK_QUALITY_OPCODE) {
+                // Return parameters: status, handle, link quality
+                const uint8_t *params = hci_event_command_complete_get_return_parameters(packet);
+                if (params[0] != ERROR_CODE_SUCCESS) {
+                    break;
+                }
+                l = find_link(little_endian_read_16(params, 1));
+                if (l) {
+                    l->link_quality = params[3];
+                    l->link_quality_valid = true;
+                }
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+void link_health_start(void) {
+    memset(links, 0, sizeof(links));
+    windows_since_log = 0;
+    poll_running = false;
+    poll_next = 0;
+
+    hci_event_callback.callback = &hci_event_handler;
+    hci_add_event_handler(&hci_event_callback);
+
+    btstack_run_loop_set_timer_handler(&poll_timer, poll_handler);
+    btstack_run_loop_set_timer_handler(&window_timer, window_handler);
+    btstack_run_loop_set_timer(&window_timer, CONFIG_PICONTROLLER_LINK_HEALTH_WINDOW_MS);
+    btstack_run_loop_add_timer(&window_timer);
+}
+
+void link_health_connected(int idx, hci_con_handle_t handle) {
+    link_t *l = &links[idx];
+    memset(l, 0, sizeof(*l));
+    l->connected = true;
+    l->handle = handle;
+    l->le = gap_get_connection_type(handle) == GAP_CONNECTION_LE;
+    l->connected_us = time_us_32();
+
+    if (dropped_us[idx] != 0) {
+        logi("link: pad %d reconnected %lu ms after drop\n", idx,
+             (unsigned long)((l->connected_us - dropped_us[idx]) / 1000));
+    }
+}
+
+void link_health_disconnected(int idx) {
+    link_t *l = &links[idx];
+    if (!l->connected) {
+        return;
+    }
+
+    logi("link: pad %d closed after %lu s, %lu reports, %lu gaps, %lu degraded windows\n", idx,
+         (unsigned long)((time_us_32() - l->connected_us) / 1000000), (unsigned long)l->reports,
+         (unsigned long)l->gaps, (unsigned long)l->degraded_windows);
+    l->connected = false;
+}
+
+void link_health_report(int idx) {
+    link_t *l = &links[idx];
+    if (!l->connected) {
+        return;
+    }
+
+    uint32_t now = time_us_32();
+    l->reports++;
+    if (l->window_reports < UINT16_MAX) {
+        l->window_reports++;
+    }
+
+    if (l->last_us != 0) {
+        uint32_t interval_us = now - l->last_us;
+        if (l->interval_avg_us == 0) {
+            l->interval_avg_us = interval_us;
+        } else {
+            l->interval_avg_us = (uint32_t)((int32_t)l->interval_avg_us +
+                                            ((int32_t)interval_us - (int32_t)l->interval_avg_us) / 16);
+        }
+        if (interval_us > l->period_max_us) {
+            l->period_max_us = interval_us;
+        }
+
+        size_t bucket = 0;
+        while (bucket < HISTOGRAM_BUCKETS - 1 && interval_us > histogram_ms[bucket] * 1000u) {
+            bucket++;
+        }
+        l->histogram[bucket]++;
+
+        if (interval_us > CONFIG_PICONTROLLER_LINK_HEALTH_GAP_MS * 1000u) {
+            l->gaps++;
+            if (l->window_gaps < UINT16_MAX) {
+                l->window_gaps++;
+            }
+        }
+    }
+    l->last_us = now | 1;
+}
+
+#endif /* CONFIG_PICONTROLLER_LINK_HEALTH */
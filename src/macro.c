@@ -0,0 +1,197 @@
+/*
+ * Frame-accurate macro and turbo engine
+ *
+ * Triggers: CAPTURE is a hotkey modifier (see hotkey.h). While it is held,
+ * pressing one of the trigger buttons fires an action and the whole chord
+ * is swallowed. CAPTURE on its own still works for screenshots and video
+ * capture.
+ */
+
+#include "macro.h"
+
+#include <stdio.h>
+
+#include "sdkconfig.h"
+#include "hotkey.h"
+
+// Modifier used for trigger chords
+#define MACRO_MODIFIER SWITCH_MASK_CAPTURE
+
+//
+// Macro definitions
+//
+
+#define STICK_STEP(x, y, n) \
+    { .buttons = 0, .hat = SWITCH_HAT_NOTHING, .flags = MACRO_STEP_LEFT_STICK, \
+      .lx = (x), .ly = (y), .rx = SWITCH_JOYSTICK_MID, .ry = SWITCH_JOYSTICK_MID, .frames = (n) }
+
+#define BUTTON_STEP(b, n) \
+    { .buttons = (b), .hat = SWITCH_HAT_NOTHING, .flags = 0, \
+      .lx = SWITCH_JOYSTICK_MID, .ly = SWITCH_JOYSTICK_MID, \
+      .rx = SWITCH_JOYSTICK_MID, .ry = SWITCH_JOYSTICK_MID, .frames = (n) }
+
+// Press A for 4 frames, release for 4
+static const macro_step_t macro_tap_a[] = {
+    BUTTON_STEP(SWITCH_MASK_A, 4),
+    BUTTON_STEP(0, 4),
+};
+
+// Jump (B), then attack (A) 10 frames later
+static const macro_step_t macro_jump_attack[] = {
+    BUTTON_STEP(SWITCH_MASK_B, 4),
+    BUTTON_STEP(0, 6),
+    BUTTON_STEP(SWITCH_MASK_A, 4),
+    BUTTON_STEP(0, 4),
+};
+
+// Left stick sweep through the 8 directions (test pattern)
+static const macro_step_t macro_stick_sweep[] = {
+    STICK_STEP(0x80, 0x00, 16),
+    STICK_STEP(0xFF, 0x00, 16),
+    STICK_STEP(0xFF, 0x80, 16),
+    STICK_STEP(0xFF, 0xFF, 16),
+    STICK_STEP(0x80, 0xFF, 16),
+    STICK_STEP(0x00, 0xFF, 16),
+    STICK_STEP(0x00, 0x80, 16),
+    STICK_STEP(0x00, 0x00, 16),
+    STICK_STEP(0x80, 0x80, 16),
+};
+
+#define MACRO_DEF(n, s, l) { .name = (n), .steps = (s), .step_count = sizeof(s) / sizeof((s)[0]), .loop = (l) }
+
+static const macro_t macros[] = {
+    MACRO_DEF("tap_a", macro_tap_a, true),
+    MACRO_DEF("jump_attack", macro_jump_attack, false),
+    MACRO_DEF("stick_sweep", macro_stick_sweep, true),
+};
+
+#define MACRO_COUNT (sizeof(macros) / sizeof(macros[0]))
+
+//
+// Engine state (Core 0 only)
+//
+
+static const macro_t *active_macro;
+static uint8_t active_step;
+static uint32_t step_start_frame;
+
+static bool turbo_enabled;
+static uint32_t turbo_start_frame;
+static uint16_t turbo_mask = CONFIG_PICONTROLLER_MACRO_TURBO_MASK;
+static uint8_t turbo_period = CONFIG_PICONTROLLER_MACRO_TURBO_PERIOD;
+static uint8_t turbo_on = CONFIG_PICONTROLLER_MACRO_TURBO_ON;
+
+static hotkey_layer_t trigger_layer;
+
+static void trigger_play(uint8_t index, uint32_t frame) {
+    macro_play(index, frame);
+}
+
+static void trigger_stop(uint8_t unused, uint32_t frame) {
+    (void)unused;
+    (void)frame;
+    macro_stop();
+}
+
+static void trigger_turbo(uint8_t unused, uint32_t frame) {
+    (void)unused;
+    macro_toggle_turbo(frame);
+}
+
+// CAPTURE + button
+static const hotkey_t triggers[] = {
+    { .button = SWITCH_MASK_A,  .action = trigger_play,  .arg = 0 },
+    { .button = SWITCH_MASK_B,  .action = trigger_play,  .arg = 1 },
+    { .button = SWITCH_MASK_X,  .action = trigger_play,  .arg = 2 },
+    { .button = SWITCH_MASK_Y,  .action = trigger_stop,  .arg = 0 },
+    { .button = SWITCH_MASK_ZR, .action = trigger_turbo, .arg = 0 },
+};
+
+#define TRIGGER_COUNT (sizeof(triggers) / sizeof(triggers[0]))
+
+void macro_init(uint32_t frame) {
+    active_macro = NULL;
+    turbo_enabled = false;
+    hotkey_layer_init(&trigger_layer, MACRO_MODIFIER, true, triggers, TRIGGER_COUNT);
+
+#if CONFIG_PICONTROLLER_MACRO_AUTOSTART >= 0
+    macro_play(CONFIG_PICONTROLLER_MACRO_AUTOSTART, frame);
+#else
+    (void)frame;
+#endif
+}
+
+void macro_play(uint8_t index, uint32_t frame) {
+    if (index >= MACRO_COUNT) {
+        return;
+    }
+
+    active_macro = &macros[index];
+    active_step = 0;
+    step_start_frame = frame;
+    printf("macro: playing %s\n", active_macro->name);
+}
+
+void macro_stop(void) {
+    active_macro = NULL;
+}
+
+void macro_toggle_turbo(uint32_t frame) {
+    turbo_enabled = !turbo_enabled;
+    turbo_start_frame = frame;
+    printf("macro: turbo %s\n", turbo_enabled ? "on" : "off");
+}
+
+void macro_set_turbo(uint16_t mask, uint8_t period, uint8_t on) {
+    turbo_mask = mask;
+    turbo_period = period ? period : 1;
+    turbo_on = on;
+}
+
+static void apply_turbo(SwitchOutReport *report, uint32_t frame) {
+    uint32_t phase = (frame - turbo_start_frame) % turbo_period;
+    if (phase >= turbo_on) {
+        report->buttons &= ~turbo_mask;
+    }
+}
+
+static void apply_macro(SwitchOutReport *report, uint32_t frame) {
+    // Advance by whole steps; a late call catches up on the frame count
+    while ((int32_t)(frame - step_start_frame) >= (int32_t)active_macro->steps[active_step].frames) {
+        step_start_frame += active_macro->steps[active_step].frames;
+        if (++active_step >= active_macro->step_count) {
+            if (!active_macro->loop) {
+                active_macro = NULL;
+                return;
+            }
+            active_step = 0;
+        }
+    }
+
+    const macro_step_t *step = &active_macro->steps[active_step];
+    report->buttons |= step->buttons;
+    if (step->hat != SWITCH_HAT_NOTHING) {
+        report->hat = step->hat;
+    }
+    if (step->flags & MACRO_STEP_LEFT_STICK) {
+        report->lx = step->lx;
+        report->ly = step->ly;
+    }
+    if (step->flags & MACRO_STEP_RIGHT_STICK) {
+        report->rx = step->rx;
+        report->ry = step->ry;
+    }
+}
+
+void macro_triggers(SwitchOutReport *report, uint32_t frame) {
+    hotkey_layer_apply(&trigger_layer, report, frame);
+}
+
+void macro_apply(SwitchOutReport *report, uint32_t frame) {
+    if (turbo_enabled) {
+        apply_turbo(report, frame);
+    }
+    if (active_macro) {
+        apply_macro(report, frame);
+    }
+}
@@ -13,6 +13,8 @@
 #include <uni.h>
 
 #include "sdkconfig.h"
+#include "bench.h"
+#include "clock_profile.h"
 #include "usb_task.h"
 
 // Sanity check
@@ -25,6 +27,8 @@ struct uni_platform *get_my_platform(void);
 
 // Bluetooth task - runs on Core 1
 static void bluetooth_core_task(void) {
+    bench_init_core();
+
     // Initialize CYW43 driver (enables Bluetooth)
     if (cyw43_arch_init()) {
         loge("Failed to initialize cyw43_arch\n");
@@ -45,7 +49,11 @@ static void bluetooth_core_task(void) {
 }
 
 int main(void) {
+    // Clocks first, so stdio is set up for the final clk_peri
+    clock_profile_apply();
     stdio_init_all();
+    clock_profile_check();
+    bench_init_core();
 
     // Launch Bluetooth on Core 1
     multicore_launch_core1(bluetooth_core_task);
@@ -0,0 +1,132 @@
+/*
+ * Gyro-to-stick motion aiming
+ *
+ * Per sample and per axis:
+ *   1. Bias drift: while the rate stays inside the stillness band for long
+ *      enough, the zero-rate offset slowly tracks the raw reading.
+ *   2. Low-pass: single-pole IIR on the bias-corrected rate.
+ *   3. Sensitivity: rate in deg/s times a base gain (stick units per deg/s).
+ *   4. Acceleration: the gain ramps up linearly between the threshold speed
+ *      and threshold + range, so slow motion stays precise and fast flicks
+ *      still reach full deflection.
+ *
+ * Every constant that would need a divide is folded at compile time.
+ */
+
+#include "motion_aim.h"
+
+#include <string.h>
+
+#include "sdkconfig.h"
+
+// Compile-time constants derived from sdkconfig.h
+#define COUNTS_PER_DPS   CONFIG_PICONTROLLER_MOTION_AIM_COUNTS_PER_DPS
+#define DPS_PER_COUNT_Q16 (65536 / COUNTS_PER_DPS)
+#define MAX_RATE_DPS     2000
+#define MAX_RATE_Q4      (MAX_RATE_DPS * COUNTS_PER_DPS * 16)
+#define STILL_BAND_Q8    (CONFIG_PICONTROLLER_MOTION_AIM_STILL_DPS * COUNTS_PER_DPS * 256)
+#define BASE_GAIN_Q8     ((CONFIG_PICONTROLLER_MOTION_AIM_SENSITIVITY * 256) / 100)
+#define ACCEL_Q8         ((CONFIG_PICONTROLLER_MOTION_AIM_ACCEL * 256) / 100)
+#define INV_RANGE_Q16    (65536 / CONFIG_PICONTROLLER_MOTION_AIM_ACCEL_RANGE)
+#define MAX_DEFLECT_Q8   (127 * 256)
+
+static inline int32_t clamp_i32(int32_t v, int32_t lo, int32_t hi) {
+    if (v < lo) {
+        return lo;
+    }
+    if (v > hi) {
+        return hi;
+    }
+    return v;
+}
+
+// Filter one axis and return the bias-corrected, low-passed rate (Q8 counts)
+static int32_t filter_axis(motion_aim_axis_t *axis, int32_t raw) {
+    int32_t raw_q8 = clamp_i32(raw, INT16_MIN, INT16_MAX) * 256;
+    int32_t diff = raw_q8 - axis->bias_q8;
+
+    // Bias drift: only learn while the pad is resting
+    if (diff > -STILL_BAND_Q8 && diff < STILL_BAND_Q8) {
+        if (axis->still_count < CONFIG_PICONTROLLER_MOTION_AIM_STILL_SAMPLES) {
+            axis->still_count++;
+        } else {
+            axis->bias_q8 += diff >> CONFIG_PICONTROLLER_MOTION_AIM_BIAS_SHIFT;
+        }
+    } else {
+        axis->still_count = 0;
+    }
+
+    // Low-pass the corrected rate
+    axis->lowpass_q8 += (diff - axis->lowpass_q8) >> CONFIG_PICONTROLLER_MOTION_AIM_LOWPASS_SHIFT;
+    return axis->lowpass_q8;
+}
+
+// Convert a filtered rate to stick deflection (Switch units, -127..127)
+static int32_t rate_to_deflection(int32_t rate_q8) {
+    bool negative = rate_q8 < 0;
+    uint32_t mag_q4 = (uint32_t)(negative ? -rate_q8 : rate_q8) >> 4;
+    if (mag_q4 > MAX_RATE_Q4) {
+        mag_q4 = MAX_RATE_Q4;
+    }
+
+    // Rate in deg/s, Q8
+    int32_t dps_q8 = (int32_t)((mag_q4 * DPS_PER_COUNT_Q16) >> 12);
+
+    // Base sensitivity
+    int32_t deflect_q8 = (dps_q8 * BASE_GAIN_Q8) >> 8;
+    if (deflect_q8 > MAX_DEFLECT_Q8) {
+        deflect_q8 = MAX_DEFLECT_Q8;
+    }
+
+    // Acceleration curve
+    int32_t over = clamp_i32((dps_q8 >> 8) - CONFIG_PICONTROLLER_MOTION_AIM_ACCEL_THRESHOLD,
+                             0, CONFIG_PICONTROLLER_MOTION_AIM_ACCEL_RANGE);
+    int32_t mult_q8 = 256 + ((ACCEL_Q8 * over * INV_RANGE_Q16) >> 16);
+    deflect_q8 = (deflect_q8 * mult_q8) >> 8;
+    if (deflect_q8 > MAX_DEFLECT_Q8) {
+        deflect_q8 = MAX_DEFLECT_Q8;
+    }
+
+    // Round to nearest stick unit
+    int32_t deflect = (deflect_q8 + 128) >> 8;
+    return negative ? -deflect : deflect;
+}
+
+static uint8_t add_deflection(uint8_t axis, int32_t deflection) {
+    int32_t v = (int32_t)axis + deflection;
+    return (uint8_t)clamp_i32(v, SWITCH_JOYSTICK_MIN, SWITCH_JOYSTICK_MAX);
+}
+
+void motion_aim_reset(motion_aim_t *aim) {
+    memset(aim, 0, sizeof(*aim));
+}
+
+void motion_aim_update(motion_aim_t *aim,
+                       const int32_t gyro[3],
+                       bool ratchet,
+                       SwitchOutReport *report) {
+    int32_t yaw = filter_axis(&aim->yaw, gyro[CONFIG_PICONTROLLER_MOTION_AIM_YAW_AXIS]);
+    int32_t pitch = filter_axis(&aim->pitch, gyro[CONFIG_PICONTROLLER_MOTION_AIM_PITCH_AXIS]);
+
+    // Ratchet: suspend output and drop filter history so release does not jump
+    if (ratchet) {
+        aim->yaw.lowpass_q8 = 0;
+        aim->pitch.lowpass_q8 = 0;
+        return;
+    }
+
+    // Positive yaw turns left and positive pitch tilts up; Switch sticks
+    // grow to the right and downwards, so both are negated by default
+    int32_t dx = -rate_to_deflection(yaw);
+    int32_t dy = -rate_to_deflection(pitch);
+
+#if CONFIG_PICONTROLLER_MOTION_AIM_INVERT_X
+    dx = -dx;
+#endif
+#if CONFIG_PICONTROLLER_MOTION_AIM_INVERT_Y
+    dy = -dy;
+#endif
+
+    report->rx = add_deflection(report->rx, dx);
+    report->ry = add_deflection(report->ry, dy);
+}
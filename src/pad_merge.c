@@ -0,0 +1,120 @@
+/*
+ * Two-pad merge ("co-pilot") rules
+ *
+ * Buttons: OR of every pad, restricted to the buttons each pad owns.
+ * Hat:     first non-neutral hat in slot order (if the pad owns it).
+ * Sticks:  per stick, one of the PAD_MERGE_STICK_* modes.
+ *
+ * With a single connected pad the result is that pad's report unchanged
+ * (for the default ownership), so single-player behaviour is untouched.
+ */
+
+#include "pad_merge.h"
+
+#include "sdkconfig.h"
+
+// Deflection (Switch units) a priority pad needs before it takes over
+#define PRIORITY_THRESHOLD 16
+
+typedef struct {
+    uint8_t x;
+    uint8_t y;
+} stick_t;
+
+static uint16_t button_owner(uint8_t pad) {
+    switch (pad) {
+        case 0:
+            return CONFIG_PICONTROLLER_MERGE_PAD0_BUTTONS;
+        case 1:
+            return CONFIG_PICONTROLLER_MERGE_PAD1_BUTTONS;
+        default:
+            return 0xFFFF;
+    }
+}
+
+static bool hat_owner(uint8_t pad) {
+    switch (pad) {
+        case 0:
+            return CONFIG_PICONTROLLER_MERGE_PAD0_HAT;
+        case 1:
+            return CONFIG_PICONTROLLER_MERGE_PAD1_HAT;
+        default:
+            return true;
+    }
+}
+
+static int32_t magnitude_sq(stick_t s) {
+    int32_t dx = (int32_t)s.x - SWITCH_JOYSTICK_MID;
+    int32_t dy = (int32_t)s.y - SWITCH_JOYSTICK_MID;
+    return dx * dx + dy * dy;
+}
+
+static stick_t get_stick(const SwitchOutReport *report, bool right) {
+    stick_t s = right ? (stick_t){ report->rx, report->ry } : (stick_t){ report->lx, report->ly };
+    return s;
+}
+
+static stick_t merge_stick(int mode, const SwitchOutReport *pads, const bool *active, uint8_t count, bool right) {
+    stick_t best = { SWITCH_JOYSTICK_MID, SWITCH_JOYSTICK_MID };
+    int32_t best_mag = -1;
+
+    for (uint8_t i = 0; i < count; i++) {
+        if (!active[i]) {
+            continue;
+        }
+        stick_t s = get_stick(&pads[i], right);
+        int32_t mag = magnitude_sq(s);
+
+        switch (mode) {
+            case PAD_MERGE_STICK_PAD0:
+            case PAD_MERGE_STICK_PAD1:
+                if (i == mode - PAD_MERGE_STICK_PAD0) {
+                    return s;
+                }
+                break;
+
+            case PAD_MERGE_STICK_PRIORITY:
+                if (mag > PRIORITY_THRESHOLD * PRIORITY_THRESHOLD) {
+                    return s;
+                }
+                // Nobody past the threshold: the lowest active slot keeps
+                // its small deflections instead of a dead zone
+                if (best_mag < 0) {
+                    best = s;
+                    best_mag = mag;
+                }
+                break;
+
+            default:
+                if (mag > best_mag) {
+                    best = s;
+                    best_mag = mag;
+                }
+                break;
+        }
+    }
+
+    return best;
+}
+
+void pad_merge(const SwitchOutReport *pads, const bool *active, uint8_t count, SwitchOutReport *out) {
+    out->buttons = 0;
+    out->hat = SWITCH_HAT_NOTHING;
+
+    for (uint8_t i = 0; i < count; i++) {
+        if (!active[i]) {
+            continue;
+        }
+        out->buttons |= pads[i].buttons & button_owner(i);
+        if (out->hat == SWITCH_HAT_NOTHING && hat_owner(i)) {
+            out->hat = pads[i].hat;
+        }
+    }
+
+    stick_t left = merge_stick(CONFIG_PICONTROLLER_MERGE_LEFT_STICK, pads, active, count, false);
+    stick_t right = merge_stick(CONFIG_PICONTROLLER_MERGE_RIGHT_STICK, pads, active, count, true);
+    out->lx = left.x;
+    out->ly = left.y;
+    out->rx = right.x;
+    out->ry = right.y;
+}
@@ -0,0 +1,196 @@
+/*
+ * Runtime mapping profiles
+ *
+ * Hotkeys (HOME held):
+ *   HOME + Y / B / A / X   select profile 0 / 1 / 2 / 3
+ *   HOME + L / R           previous / next profile
+ * HOME is held back from the console while it is down, so a profile
+ * switch never sends it; pressed on its own it is replayed as a tap on
+ * release, or passed through once held long enough (see hotkey.h).
+ *
+ * Profiles are described below as a per-button remap plus a curve, and
+ * expanded by profile_init() into byte-indexed lookup tables: a report
+ * is remapped with two table loads for the buttons and one per stick
+ * axis. The active profile is published through one pointer, written
+ * with a single aligned store.
+ */
+
+#include "profile.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "sdkconfig.h"
+#include "hotkey.h"
+#include "macro.h"
+
+// Bit positions of the Switch buttons in SwitchOutReport.buttons
+enum {
+    BIT_Y, BIT_B, BIT_A, BIT_X,
+    BIT_L, BIT_R, BIT_ZL, BIT_ZR,
+    BIT_MINUS, BIT_PLUS, BIT_L3, BIT_R3,
+    BIT_HOME, BIT_CAPTURE,
+};
+
+// Remap target that drops the button
+#define PROFILE_UNMAPPED (1U << 15)
+
+// Profile description; remap entries left at 0 keep the button as is
+typedef struct {
+    const char *name;
+    uint16_t remap[16];
+    uint8_t curve;
+    uint16_t turbo_mask;
+} profile_def_t;
+
+static const profile_def_t profile_defs[] = {
+    {
+        .name = "standard",
+        .curve = PROFILE_CURVE_LINEAR,
+        .turbo_mask = CONFIG_PICONTROLLER_MACRO_TURBO_MASK,
+    },
+    {
+        // Face buttons by position instead of by label
+        .name = "positional",
+        .remap = {
+            [BIT_A] = SWITCH_MASK_B, [BIT_B] = SWITCH_MASK_A,
+            [BIT_X] = SWITCH_MASK_Y, [BIT_Y] = SWITCH_MASK_X,
+        },
+        .curve = PROFILE_CURVE_LINEAR,
+        .turbo_mask = CONFIG_PICONTROLLER_MACRO_TURBO_MASK,
+    },
+    {
+        .name = "precision",
+        .curve = PROFILE_CURVE_PRECISE,
+        .turbo_mask = CONFIG_PICONTROLLER_MACRO_TURBO_MASK,
+    },
+    {
+        // Shoulders and triggers swapped, turbo on fire
+        .name = "shooter",
+        .remap = {
+            [BIT_L] = SWITCH_MASK_ZL, [BIT_ZL] = SWITCH_MASK_L,
+            [BIT_R] = SWITCH_MASK_ZR, [BIT_ZR] = SWITCH_MASK_R,
+        },
+        .curve = PROFILE_CURVE_AGGRESSIVE,
+        .turbo_mask = SWITCH_MASK_ZR,
+    },
+};
+
+#define PROFILE_COUNT (sizeof(profile_defs) / sizeof(profile_defs[0]))
+
+static profile_t profiles[PROFILE_COUNT];
+static const profile_t *volatile active_profile;
+static uint8_t active_index;
+
+static hotkey_layer_t profile_layer;
+
+static void hotkey_select(uint8_t index, uint32_t frame) {
+    (void)frame;
+    profile_select(index);
+}
+
+static void hotkey_cycle(uint8_t forward, uint32_t frame) {
+    (void)frame;
+    uint8_t index = (uint8_t)(forward ? active_index + 1u : active_index + PROFILE_COUNT - 1u);
+    profile_select(index % PROFILE_COUNT);
+}
+
+// HOME + button
+static const hotkey_t home_hotkeys[] = {
+    { .button = SWITCH_MASK_Y, .action = hotkey_select, .arg = 0 },
+    { .button = SWITCH_MASK_B, .action = hotkey_select, .arg = 1 },
+    { .button = SWITCH_MASK_A, .action = hotkey_select, .arg = 2 },
+    { .button = SWITCH_MASK_X, .action = hotkey_select, .arg = 3 },
+    { .button = SWITCH_MASK_L, .action = hotkey_cycle,  .arg = 0 },
+    { .button = SWITCH_MASK_R, .action = hotkey_cycle,  .arg = 1 },
+};
+
+#define HOTKEY_COUNT (sizeof(home_hotkeys) / sizeof(home_hotkeys[0]))
+
+// Curve value for one Switch axis value (0x80 = center)
+static uint8_t curve_value(uint8_t curve, uint8_t value) {
+    int32_t x = (int32_t)value - SWITCH_JOYSTICK_MID;
+    int32_t scale = x < 0 ? 128 : 127;
+    int32_t m = x < 0 ? -x : x;
+    int32_t y;
+
+    switch (curve) {
+        case PROFILE_CURVE_PRECISE:
+            // Half linear, half cubic
+            y = (m + m * m * m / (scale * scale)) / 2;
+            break;
+        case PROFILE_CURVE_AGGRESSIVE:
+            // Quadratic ease-out
+            y = 2 * m - m * m / scale;
+            break;
+        default:
+            y = m;
+            break;
+    }
+
+    return (uint8_t)(SWITCH_JOYSTICK_MID + (x < 0 ? -y : y));
+}
+
+static void build_profile(profile_t *profile, const profile_def_t *def) {
+    uint16_t map[16];
+    for (uint8_t bit = 0; bit < 16; bit++) {
+        map[bit] = def->remap[bit] ? (def->remap[bit] & ~PROFILE_UNMAPPED) : (uint16_t)(1U << bit);
+    }
+
+    for (uint16_t value = 0; value < 256; value++) {
+        uint16_t lo = 0;
+        uint16_t hi = 0;
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            if (value & (1U << bit)) {
+                lo |= map[bit];
+                hi |= map[bit + 8];
+            }
+        }
+        profile->buttons_lo[value] = lo;
+        profile->buttons_hi[value] = hi;
+        profile->stick[value] = curve_value(def->curve, (uint8_t)value);
+    }
+
+    profile->name = def->name;
+    profile->turbo_mask = def->turbo_mask;
+    profile->turbo_period = CONFIG_PICONTROLLER_MACRO_TURBO_PERIOD;
+    profile->turbo_on = CONFIG_PICONTROLLER_MACRO_TURBO_ON;
+}
+
+void profile_init(void) {
+    for (uint8_t i = 0; i < PROFILE_COUNT; i++) {
+        build_profile(&profiles[i], &profile_defs[i]);
+    }
+    hotkey_layer_init(&profile_layer, SWITCH_MASK_HOME, true, home_hotkeys, HOTKEY_COUNT);
+    profile_select(CONFIG_PICONTROLLER_PROFILES_DEFAULT);
+}
+
+void profile_select(uint8_t index) {
+    if (index >= PROFILE_COUNT) {
+        return;
+    }
+
+    const profile_t *profile = &profiles[index];
+    active_index = index;
+    active_profile = profile;
+
+#ifdef CONFIG_PICONTROLLER_MACRO
+    macro_set_turbo(profile->turbo_mask, profile->turbo_period, profile->turbo_on);
+#endif
+
+    printf("profile: %u (%s)\n", index, profile->name);
+}
+
+void profile_hotkeys(SwitchOutReport *report, uint32_t frame) {
+    hotkey_layer_apply(&profile_layer, report, frame);
+}
+
+void profile_apply(SwitchOutReport *report) {
+    const profile_t *profile = active_profile;
+    uint16_t buttons = report->buttons;
+    report->buttons = profile->buttons_lo[buttons & 0xFF] | profile->buttons_hi[buttons >> 8];
+    report->lx = profile->stick[report->lx];
+    report->ly = profile->stick[report->ly];
+    report->rx = profile->stick[report->rx];
+    report->ry = profile->stick[report->ry];
+}
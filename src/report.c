@@ -1,46 +1,233 @@
 /*
- * Thread-safe gamepad report sharing between cores
+ * Lock-free gamepad report sharing between cores
+ *
+ * Each controller has its own slot guarded by a sequence counter
+ * (single writer on Core 1, single reader on Core 0). The writer makes the
+ * counter odd, updates the report and makes it even again; the reader
+ * retries if it saw an odd value or the counter changed under it. Neither
+ * side ever blocks, so one pad's radio timing cannot delay the other.
+ *
+ * The sequence counters double as generation counters: Core 0 uses them,
+ * together with the update timestamps and the Bluetooth heartbeat, to
+ * stop forwarding input that is no longer being refreshed.
+ *
+ * A slot holds either a finished report or, with
+ * CONFIG_PICONTROLLER_RAW_HANDOFF, a raw controller sample. Core 0
+ * translates a raw sample once per new sequence number while merging, so
+ * the report it sends is built from the newest sample at send time.
  */
 
 #include "report.h"
 
 #include <string.h>
 #include <pico/multicore.h>
-#include <pico/async_context.h>
-#include <pico/cyw43_arch.h>
-
-// Shared report between cores
-static SwitchOutReport shared_report = {
-    .buttons = 0,
-    .hat = SWITCH_HAT_NOTHING,
-    .lx = SWITCH_JOYSTICK_MID,
-    .ly = SWITCH_JOYSTICK_MID,
-    .rx = SWITCH_JOYSTICK_MID,
-    .ry = SWITCH_JOYSTICK_MID,
-};
-
-void set_global_gamepad_report(const SwitchOutReport *report) {
-    if (!report) {
+#include <pico/time.h>
+#include <hardware/sync.h>
+
+#include "sdkconfig.h"
+#include "pad_merge.h"
+#include "stick_predict.h"
+#include "translate.h"
+
+#define PAD_SLOTS GAMEPAD_SLOTS
+
+typedef struct {
+    volatile uint32_t sequence;
+    volatile bool active;
+    volatile uint32_t deadline_us;  // 0 = no stale input deadline
+    uint32_t updated_us;
+    SwitchOutReport report;
+#ifdef CONFIG_PICONTROLLER_RAW_HANDOFF
+    bool raw;
+    raw_sample_t sample;
+#endif
+} report_slot_t;
+
+// Shared slots between cores
+static report_slot_t slots[PAD_SLOTS];
+
+#ifdef CONFIG_PICONTROLLER_RAW_HANDOFF
+// Core 0: last translated sequence and its report, per slot
+static uint32_t translated_sequence[PAD_SLOTS];
+static SwitchOutReport translated_report[PAD_SLOTS];
+#endif
+
+#ifdef CONFIG_PICONTROLLER_STICK_PREDICT
+// Core 0: stick extrapolation per slot, restarted whenever a slot drops out
+static stick_predict_t predictors[PAD_SLOTS];
+static bool predictor_live[PAD_SLOTS];
+#endif
+
+// Last heartbeat from Core 1 (0 = none yet)
+static volatile uint32_t heartbeat_us;
+
+void set_global_gamepad_report(uint8_t pad, const SwitchOutReport *report) {
+    if (!report || pad >= PAD_SLOTS) {
         return;
     }
 
-    async_context_t *context = cyw43_arch_async_context();
-    async_context_acquire_lock_blocking(context);
-    memcpy(&shared_report, report, sizeof(shared_report));
-    async_context_release_lock(context);
+    report_slot_t *slot = &slots[pad];
+    slot->sequence++;
+    __dmb();
+    memcpy(&slot->report, report, sizeof(slot->report));
+#ifdef CONFIG_PICONTROLLER_RAW_HANDOFF
+    slot->raw = false;
+#endif
+    slot->updated_us = time_us_32();
+    __dmb();
+    slot->sequence++;
 
     // Signal USB core that new data is available
     multicore_fifo_push_timeout_us(0, 1);
 }
 
+#ifdef CONFIG_PICONTROLLER_RAW_HANDOFF
+void set_global_gamepad_sample(uint8_t pad, const raw_sample_t *sample) {
+    if (!sample || pad >= PAD_SLOTS) {
+        return;
+    }
+
+    report_slot_t *slot = &slots[pad];
+    slot->sequence++;
+    __dmb();
+    memcpy(&slot->sample, sample, sizeof(slot->sample));
+    slot->raw = true;
+    slot->updated_us = sample->timestamp_us;
+    __dmb();
+    slot->sequence++;
+
+    multicore_fifo_push_timeout_us(0, 1);
+}
+#endif
+
+void set_global_gamepad_active(uint8_t pad, bool active) {
+    if (pad >= PAD_SLOTS) {
+        return;
+    }
+
+    slots[pad].active = active;
+    __dmb();
+}
+
+void set_global_gamepad_deadline(uint8_t pad, uint32_t deadline_ms) {
+    if (pad >= PAD_SLOTS) {
+        return;
+    }
+
+    slots[pad].deadline_us = deadline_ms * 1000u;
+}
+
+void set_global_heartbeat(void) {
+    heartbeat_us = time_us_32() | 1;
+}
+
 static uint32_t fifo_unused;
 
+#ifdef CONFIG_PICONTROLLER_RAW_HANDOFF
+// Copy a consistent snapshot of one slot, translating a new raw sample;
+// returns its update time
+static uint32_t read_slot(uint8_t pad, SwitchOutReport *report) {
+    const report_slot_t *slot = &slots[pad];
+    raw_sample_t sample;
+    uint32_t before, after, updated_us;
+    bool raw;
+    do {
+        before = slot->sequence;
+        __dmb();
+        raw = slot->raw;
+        if (raw) {
+            memcpy(&sample, (const void *)&slot->sample, sizeof(sample));
+        } else {
+            memcpy(report, (const void *)&slot->report, sizeof(*report));
+        }
+        updated_us = slot->updated_us;
+        __dmb();
+        after = slot->sequence;
+    } while ((before & 1) || before != after);
+
+    if (raw) {
+        if (before != translated_sequence[pad]) {
+            translate_pad(pad, &sample, &translated_report[pad]);
+            translated_sequence[pad] = before;
+        }
+        *report = translated_report[pad];
+    }
+    return updated_us;
+}
+#else
+// Copy a consistent snapshot of one slot; returns its update time
+static uint32_t read_slot(uint8_t pad, SwitchOutReport *report) {
+    const report_slot_t *slot = &slots[pad];
+    uint32_t before, after, updated_us;
+    do {
+        before = slot->sequence;
+        __dmb();
+        memcpy(report, (const void *)&slot->report, sizeof(*report));
+        updated_us = slot->updated_us;
+        __dmb();
+        after = slot->sequence;
+    } while ((before & 1) || before != after);
+    return updated_us;
+}
+#endif
+
+// Microseconds since the last heartbeat; false if none was seen yet
+static bool get_heartbeat_age(uint32_t *age_us) {
+    uint32_t beat = heartbeat_us;
+    if (beat == 0) {
+        return false;
+    }
+    *age_us = time_us_32() - beat;
+    return true;
+}
+
 void get_global_gamepad_report(SwitchOutReport *report) {
     // Wait for signal from Bluetooth core (with short timeout)
     multicore_fifo_pop_timeout_us(1, &fifo_unused);
 
-    async_context_t *context = cyw43_arch_async_context();
-    async_context_acquire_lock_blocking(context);
-    memcpy(report, &shared_report, sizeof(*report));
-    async_context_release_lock(context);
+    SwitchOutReport pads[PAD_SLOTS];
+    bool active[PAD_SLOTS];
+    uint32_t now = time_us_32();
+
+    // A silent Bluetooth core means nothing it published can be trusted
+    uint32_t beat_age;
+    bool core1_alive = !get_heartbeat_age(&beat_age) ||
+                       beat_age < CONFIG_PICONTROLLER_HEARTBEAT_TIMEOUT_MS * 1000u;
+
+    for (uint8_t i = 0; i < PAD_SLOTS; i++) {
+        active[i] = core1_alive && slots[i].active;
+        if (active[i]) {
+            uint32_t updated_us = read_slot(i, &pads[i]);
+            uint32_t deadline_us = slots[i].deadline_us;
+            if (deadline_us && now - updated_us > deadline_us) {
+                active[i] = false;
+            }
+#ifdef CONFIG_PICONTROLLER_STICK_PREDICT
+            if (active[i]) {
+                if (!predictor_live[i]) {
+                    stick_predict_reset(&predictors[i], CONFIG_PICONTROLLER_STICK_PREDICT_HORIZON_US);
+                    predictor_live[i] = true;
+                }
+                stick_predict_apply(&predictors[i], updated_us, now, &pads[i]);
+            }
+#endif
+        }
+
+#ifdef CONFIG_PICONTROLLER_STICK_PREDICT
+        if (!active[i]) {
+            predictor_live[i] = false;
+        }
+#endif
+    }
+
+    pad_merge(pads, active, PAD_SLOTS, report);
+}
+
+bool get_global_gamepad_any_active(void) {
+    for (uint8_t i = 0; i < PAD_SLOTS; i++) {
+        if (slots[i].active) {
+            return true;
+        }
+    }
+    return false;
 }
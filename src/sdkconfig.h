@@ -1,9 +1,9 @@
 // Bluepad32 SDK configuration for picontroller2
 // Emulates ESP-IDF menuconfig
 
-// Single controller support (simplified from 4)
-#define CONFIG_BLUEPAD32_MAX_DEVICES 1
-#define CONFIG_BLUEPAD32_MAX_ALLOWLIST 1
+// Up to two controllers, merged into one Switch report (co-pilot)
+#define CONFIG_BLUEPAD32_MAX_DEVICES 2
+#define CONFIG_BLUEPAD32_MAX_ALLOWLIST 2
 
 // Security and BLE settings
 #define CONFIG_BLUEPAD32_GAP_SECURITY 1
@@ -15,3 +15,168 @@
 
 // Log level: 2 = Info
 #define CONFIG_BLUEPAD32_LOG_LEVEL 2
+
+// Cycle-count benchmarks of hot-path stages, printed over UART
+// #define CONFIG_PICONTROLLER_BENCH 1
+
+// Gyro-to-stick motion aiming (adds gyro rate to the right stick)
+// #define CONFIG_PICONTROLLER_MOTION_AIM 1
+#define CONFIG_PICONTROLLER_MOTION_AIM_YAW_AXIS 1          // gyro[] index for horizontal aim
+#define CONFIG_PICONTROLLER_MOTION_AIM_PITCH_AXIS 0        // gyro[] index for vertical aim
+#define CONFIG_PICONTROLLER_MOTION_AIM_INVERT_X 0
+#define CONFIG_PICONTROLLER_MOTION_AIM_INVERT_Y 0
+#define CONFIG_PICONTROLLER_MOTION_AIM_COUNTS_PER_DPS 16   // gyro counts per deg/s
+#define CONFIG_PICONTROLLER_MOTION_AIM_SENSITIVITY 40      // stick units per 100 deg/s
+#define CONFIG_PICONTROLLER_MOTION_AIM_ACCEL 100           // extra gain (%) at full acceleration
+#define CONFIG_PICONTROLLER_MOTION_AIM_ACCEL_THRESHOLD 60  // deg/s where acceleration starts
+#define CONFIG_PICONTROLLER_MOTION_AIM_ACCEL_RANGE 240     // deg/s to reach full acceleration
+#define CONFIG_PICONTROLLER_MOTION_AIM_LOWPASS_SHIFT 2     // IIR weight 1/2^n per sample
+#define CONFIG_PICONTROLLER_MOTION_AIM_BIAS_SHIFT 6        // bias tracking weight 1/2^n
+#define CONFIG_PICONTROLLER_MOTION_AIM_STILL_DPS 8         // stillness band for bias tracking
+#define CONFIG_PICONTROLLER_MOTION_AIM_STILL_SAMPLES 32    // samples at rest before tracking
+// Ratchet: a bluepad32 BUTTON_* held to suspend gyro aim; that button is
+// then no longer sent to the console. 0 = no ratchet, all buttons pass
+#define CONFIG_PICONTROLLER_MOTION_AIM_RATCHET 0
+
+// Adaptive One-Euro stick smoothing (cutoffs in centi-hertz)
+// Added group delay per configuration is logged at startup
+// #define CONFIG_PICONTROLLER_STICK_FILTER 1
+#define CONFIG_PICONTROLLER_STICK_FILTER_AXES 0x0F         // bit mask: LX, LY, RX, RY
+#define CONFIG_PICONTROLLER_STICK_FILTER_MIN_CUTOFF 150    // cutoff at rest
+#define CONFIG_PICONTROLLER_STICK_FILTER_MAX_CUTOFF 6000   // cutoff ceiling during flicks
+#define CONFIG_PICONTROLLER_STICK_FILTER_BETA 100          // cHz added per 100 units/s
+#define CONFIG_PICONTROLLER_STICK_FILTER_D_CUTOFF 500      // speed estimate cutoff
+
+// Per-device stick calibration stored by BD_ADDR: centers are learned
+// automatically, ranges stay nominal until a manual calibration measures them
+// Hold MINUS + PLUS to start manual calibration, hold again to finish
+#define CONFIG_PICONTROLLER_STICK_CALIBRATION 1
+#define CONFIG_PICONTROLLER_STICK_CALIBRATION_SLOTS 8            // controllers remembered
+#define CONFIG_PICONTROLLER_STICK_CALIBRATION_HOLD_MS 3000       // manual calibration chord hold time
+
+// Macro and turbo engine on the USB core, timed in USB frames (1 ms)
+// CAPTURE + A/B/X plays a macro, CAPTURE + Y stops it, CAPTURE + ZR toggles turbo
+// #define CONFIG_PICONTROLLER_MACRO 1
+#define CONFIG_PICONTROLLER_MACRO_AUTOSTART -1                            // macro played at startup, -1 for none
+#define CONFIG_PICONTROLLER_MACRO_TURBO_MASK (SWITCH_MASK_A | SWITCH_MASK_B)  // buttons repeated by turbo
+#define CONFIG_PICONTROLLER_MACRO_TURBO_PERIOD 8                          // frames per repeat
+#define CONFIG_PICONTROLLER_MACRO_TURBO_ON 4                              // frames pressed per repeat
+
+// Runtime profiles (button remap, stick curve, turbo buttons)
+// HOME + Y/B/A/X selects profile 0-3, HOME + L/R cycles
+// #define CONFIG_PICONTROLLER_PROFILES 1
+#define CONFIG_PICONTROLLER_PROFILES_DEFAULT 0                            // profile active at startup
+
+// Two-pad merge rules (see pad_merge.h for stick modes)
+#define CONFIG_PICONTROLLER_MERGE_PAD0_BUTTONS 0xFFFF               // buttons slot 0 may press
+#define CONFIG_PICONTROLLER_MERGE_PAD1_BUTTONS 0xFFFF               // buttons slot 1 may press
+#define CONFIG_PICONTROLLER_MERGE_PAD0_HAT 1                        // slot 0 may use the D-pad
+#define CONFIG_PICONTROLLER_MERGE_PAD1_HAT 1                        // slot 1 may use the D-pad
+#define CONFIG_PICONTROLLER_MERGE_LEFT_STICK 0                      // PAD_MERGE_STICK_MAX
+#define CONFIG_PICONTROLLER_MERGE_RIGHT_STICK 0                     // PAD_MERGE_STICK_MAX
+
+// Keyboard and mouse translation (accepts keyboards and mice when pairing)
+// #define CONFIG_PICONTROLLER_KBM 1
+#define CONFIG_PICONTROLLER_KBM_MOUSE_SENSITIVITY 16      // stick units per mouse count per frame
+#define CONFIG_PICONTROLLER_KBM_MOUSE_DECAY_SHIFT 3       // stick follows mouse speed with weight 1/2^n per frame
+#define CONFIG_PICONTROLLER_KBM_MOUSE_ANTI_DEADZONE 20    // skips the game's inner stick deadzone
+
+// Virtual controllers over the debug UART for bench and load testing
+// (frames from tools/inject.py, see inject.h)
+// #define CONFIG_PICONTROLLER_INJECT 1
+#define CONFIG_PICONTROLLER_INJECT_SLOTS 2  // virtual controllers, placed after the Bluetooth slots
+
+// Core 1 publishes raw controller samples; mapping, smoothing, calibration
+// tables and motion aim run on Core 0 just before each report is sent
+// #define CONFIG_PICONTROLLER_RAW_HANDOFF 1
+
+// Stick extrapolation on Core 0 between Bluetooth reports
+// Tune with tools/stick_predict_eval.c on traces from STICK_TRACE
+// #define CONFIG_PICONTROLLER_STICK_PREDICT 1
+#define CONFIG_PICONTROLLER_STICK_PREDICT_HORIZON_US 6000   // furthest extrapolation past a sample (max 16000)
+#define CONFIG_PICONTROLLER_STICK_PREDICT_MAX_GAP_US 30000  // longer report gaps are not extrapolated
+#define CONFIG_PICONTROLLER_STICK_PREDICT_SMOOTH_SHIFT 1    // speed follows new samples with weight 1/2^n
+#define CONFIG_PICONTROLLER_STICK_PREDICT_OVERSHOOT 100     // limit as % of the last sample step
+
+// Fast-path parsers for DualShock 4, DualSense and Xbox Wireless (firmware
+// 5.x) raw reports; other pads (Switch Pro and 8BitDo pads in Switch mode
+// included) and report types keep bluepad32's parser. VERIFY runs both on
+// every report and logs where they differ; with BENCH it also logs the
+// cycles of both for the first reports (needs FAST_PARSE)
+// #define CONFIG_PICONTROLLER_FAST_PARSE 1
+// #define CONFIG_PICONTROLLER_FAST_PARSE_VERIFY 1
+#define CONFIG_PICONTROLLER_FAST_PARSE_PADS 0x07   // FAST_PARSE_DS4 | _DS5 | _XBOX
+
+// Print every controller sample's sticks as "trace:" lines (raw bluepad32 units)
+// #define CONFIG_PICONTROLLER_STICK_TRACE 1
+
+// Bluetooth link health: report gaps, RSSI and link quality per controller,
+// logged every LOG_WINDOWS windows; degraded links are renegotiated, and
+// dropped after RECONNECT_WINDOWS if that is set.
+// RSSI_MIN: BR/EDR RSSI is dB below the lower limit of the controller's
+// golden receive range (0 inside it). The spec puts that limit between
+// -56 dBm and 6 dB above the receiver sensitivity, so -20 is at most about
+// -76 dBm. Not measured on the CYW43439; check the "rssi" field of the link
+// log at a known distance before changing it.
+// RECONNECT_WINDOWS: off by default. A drop costs a full reconnect with no
+// input meanwhile, and that time ("reconnected N ms after drop") has not
+// been measured, so enable it only where the log shows links that stay
+// degraded and come back healthy after a reconnect.
+#define CONFIG_PICONTROLLER_LINK_HEALTH 1
+#define CONFIG_PICONTROLLER_LINK_HEALTH_WINDOW_MS 1000           // evaluation window
+#define CONFIG_PICONTROLLER_LINK_HEALTH_LOG_WINDOWS 10           // windows per statistics log line
+#define CONFIG_PICONTROLLER_LINK_HEALTH_GAP_MS 40                // longer report intervals count as gaps
+#define CONFIG_PICONTROLLER_LINK_HEALTH_GAP_LIMIT 3              // gaps per window that degrade a link
+#define CONFIG_PICONTROLLER_LINK_HEALTH_MIN_REPORTS 50           // reports per window to judge gaps at all
+#define CONFIG_PICONTROLLER_LINK_HEALTH_RSSI_MIN -20             // BR/EDR, dB relative to the golden range
+#define CONFIG_PICONTROLLER_LINK_HEALTH_LINK_QUALITY_MIN 0       // BR/EDR, 0-255 vendor scale, 0 = off
+#define CONFIG_PICONTROLLER_LINK_HEALTH_RECONNECT_WINDOWS 0      // degraded windows before a drop, 0 = never
+#define CONFIG_PICONTROLLER_LINK_HEALTH_RECONNECT_COOLDOWN_MS 60000  // minimum time between drops per slot
+#define CONFIG_PICONTROLLER_LINK_HEALTH_LE_INTERVAL 6            // requested LE interval, 1.25 ms units
+#define CONFIG_PICONTROLLER_LINK_HEALTH_LE_TIMEOUT 200           // LE supervision timeout, 10 ms units
+
+// Stale input protection (Core 0 sends neutral input instead)
+// The per-pad deadline applies to pads that stream reports continuously
+// (DualShock 3/4, DualSense, Switch Pro, Joy-Con); pads that only report
+// on change rely on the heartbeat alone
+#define CONFIG_PICONTROLLER_STALE_INPUT_MS 100              // per-pad deadline, 0 = off
+#define CONFIG_PICONTROLLER_HEARTBEAT_MS 10                 // Core 1 heartbeat period
+// The heartbeat timeout must outlast a flash sector erase: Core 1 erases
+// while storing link keys and calibrations (TLV bank), and the W25Q flash
+// on the Pico W and Pico 2 W takes up to 400 ms per sector (datasheet max)
+#define CONFIG_PICONTROLLER_HEARTBEAT_TIMEOUT_MS 500        // Core 1 considered stalled after this
+
+// System clock profile, selected at configure time with
+// cmake -DPICONTROLLER_CLOCK_PROFILE=default|performance|low_power, which
+// also sets the flash and CYW43 SPI dividers (see clock_profile.h). The
+// non-default profiles also need -DPICONTROLLER_ALLOW_UNVALIDATED_CLOCK=ON.
+// The performance and low_power values below are UNVALIDATED: neither has
+// been run on a Pico W or a Pico 2 W, so there are no self-check or bench
+// results for them yet. To validate a profile on a board, record the
+// "Clock:" boot lines and the usb_input/usb_tud_task/usb_output/usb_loop
+// lines (CONFIG_PICONTROLLER_BENCH, controller connected) at the default
+// and at the new profile, and run with two controllers for a while.
+#ifndef CONFIG_PICONTROLLER_CLOCK_PROFILE
+#define CONFIG_PICONTROLLER_CLOCK_PROFILE 0                  // CLOCK_PROFILE_DEFAULT
+#endif
+#ifndef CONFIG_PICONTROLLER_FLASH_CLKDIV
+#define CONFIG_PICONTROLLER_FLASH_CLKDIV 0                   // 0 = boot setting
+#endif
+#define CONFIG_PICONTROLLER_CLOCK_RP2040_PERFORMANCE_KHZ 200000
+#define CONFIG_PICONTROLLER_CLOCK_RP2040_PERFORMANCE_VOLTAGE VREG_VOLTAGE_1_15
+#define CONFIG_PICONTROLLER_CLOCK_RP2350_PERFORMANCE_KHZ 200000
+#define CONFIG_PICONTROLLER_CLOCK_RP2350_PERFORMANCE_VOLTAGE VREG_VOLTAGE_1_15
+#define CONFIG_PICONTROLLER_CLOCK_LOW_POWER_KHZ 72000
+#define CONFIG_PICONTROLLER_CLOCK_LOW_POWER_VOLTAGE VREG_VOLTAGE_1_00
+#define CONFIG_PICONTROLLER_CLOCK_VREG_SETTLE_US 1000        // wait after raising the voltage at boot
+#define CONFIG_PICONTROLLER_CLOCK_CHECK_TOLERANCE_PCT 2      // allowed clk_sys measurement error
+#define CONFIG_PICONTROLLER_CLOCK_CHECK_FLASH_BYTES 16384    // image bytes re-read uncached at boot
+
+// Idle power governor: 48 MHz and lower core voltage while no controller is
+// connected or USB is suspended; wake-up time is logged. Not validated yet:
+// the idle current and wake-up latency are unmeasured (see governor.c)
+// #define CONFIG_PICONTROLLER_GOVERNOR 1
+#define CONFIG_PICONTROLLER_GOVERNOR_IDLE_DELAY_MS 2000          // idle time before clocking down
+#define CONFIG_PICONTROLLER_GOVERNOR_IDLE_VOLTAGE VREG_VOLTAGE_0_95  // core voltage while idle
+#define CONFIG_PICONTROLLER_GOVERNOR_VREG_SETTLE_US 100          // wait after raising the voltage
+#define CONFIG_PICONTROLLER_GOVERNOR_IDLE_POLL_US 1000           // longest Core 0 wait while idle
@@ -0,0 +1,513 @@
+/*
+ * Per-device stick calibration keyed by Bluetooth address
+ *
+ * Automatic mode:
+ *   - Center: averaged over a run of samples where every axis is near the
+ *     nominal center and barely moving; learned once per connection and
+ *     used for that connection. It is only stored once a later connection
+ *     learns a center that agrees, so a stick held slightly off-center at
+ *     connect never becomes permanent drift.
+ *   - Range: the nominal full range, so a pad that was never calibrated
+ *     keeps the stock stick response. Only a manual calibration measures
+ *     a narrower range (a worn stick that never reaches the edge).
+ * Manual mode resets the range to the current (released) position and
+ * learns it from scratch while the user rotates the sticks; its result is
+ * stored right away.
+ *
+ * The tables are rebuilt only when the learned values change by more
+ * than a few units, never per sample and never in the report callback.
+ * During a manual calibration they are rebuilt as neutral, so the sticks
+ * being rotated never reach the console.
+ * Flash is written on disconnect only when the stored entry would change
+ * noticeably.
+ */
+
+#include "stick_calibration.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include <hardware/sync.h>
+#include <btstack_tlv.h>
+#include <uni.h>
+
+#include "sdkconfig.h"
+#include "switch_descriptors.h"
+
+// Deadzone for analog sticks to prevent drift (Switch units)
+#define AXIS_DEADZONE 0x0a
+
+// TLV tag for table slot n: 'P' 'C' 'L' n
+#define CALIBRATION_TLV_TAG(slot) (((uint32_t)'P' << 24) | ((uint32_t)'C' << 16) | ((uint32_t)'L' << 8) | (slot))
+
+// Automatic learning parameters (bluepad32 units)
+#define CENTER_WINDOW       48   // Max offset from nominal center treated as "released"
+#define REST_DELTA          3    // Max change between samples while at rest
+#define REST_SPREAD         6    // Max min-to-max spread over the averaged samples
+#define REST_SAMPLES        64   // Samples averaged for the center
+#define CENTER_AGREE        8    // Max difference between two learned centers to store one
+#define RANGE_REBUILD_STEP  4    // Range growth that triggers a table rebuild
+#define STORE_STEP          16   // Range or center change worth a flash write
+#define MIN_SPAN            128  // Smallest accepted center-to-edge distance
+
+static stick_calibration_entry_t table[CONFIG_PICONTROLLER_STICK_CALIBRATION_SLOTS];
+static uint16_t use_counter;
+
+static uint8_t convert_to_switch_axis(int32_t bluepad_axis) {
+    // bluepad32 reports from -512 to 511 as int32_t
+    // Switch reports from 0 to 255 as uint8_t (mid = 0x80)
+
+    bluepad_axis += 513;  // now range is 1 to 1024
+    bluepad_axis /= 4;    // now range is 0 to 256
+
+    if (bluepad_axis < SWITCH_JOYSTICK_MIN) {
+        bluepad_axis = SWITCH_JOYSTICK_MIN;
+    } else if ((bluepad_axis > (SWITCH_JOYSTICK_MID - AXIS_DEADZONE)) &&
+               (bluepad_axis < (SWITCH_JOYSTICK_MID + AXIS_DEADZONE))) {
+        // Apply deadzone - center the stick
+        bluepad_axis = SWITCH_JOYSTICK_MID;
+    } else if (bluepad_axis > SWITCH_JOYSTICK_MAX) {
+        bluepad_axis = SWITCH_JOYSTICK_MAX;
+    }
+
+    return (uint8_t)bluepad_axis;
+}
+
+static void default_axis(stick_calibration_axis_t *axis) {
+    axis->center = 0;
+    axis->min = STICK_RAW_MIN;
+    axis->max = STICK_RAW_MAX;
+}
+
+// Rebuild one axis table: rescale the learned range onto the nominal one,
+// then apply the usual deadzone and conversion
+static void build_axis_lut(uint8_t *lut, const stick_calibration_axis_t *axis) {
+    int32_t center = axis->center;
+    int32_t pos_span = axis->max - center;
+    int32_t neg_span = center - axis->min;
+    if (pos_span < MIN_SPAN) {
+        pos_span = MIN_SPAN;
+    }
+    if (neg_span < MIN_SPAN) {
+        neg_span = MIN_SPAN;
+    }
+
+    int32_t pos_scale_q16 = (STICK_RAW_MAX << 16) / pos_span;
+    int32_t neg_scale_q16 = (-STICK_RAW_MIN << 16) / neg_span;
+
+    for (int32_t i = 0; i < STICK_LUT_SIZE; i++) {
+        int32_t v = i + STICK_RAW_MIN - center;
+        int32_t nominal = (v * (v >= 0 ? pos_scale_q16 : neg_scale_q16)) >> 16;
+        lut[i] = convert_to_switch_axis(nominal);
+    }
+}
+
+// Fill the idle buffer and publish it (buffer (sequence / 2) & 1 is live)
+static void build_luts(stick_calibration_t *cal) {
+    uint32_t sequence = cal->lut_sequence + 1;
+    cal->lut_sequence = sequence;
+    __dmb();
+
+    uint8_t (*lut)[STICK_LUT_SIZE] = cal->lut[((sequence >> 1) + 1) & 1];
+    for (int i = 0; i < STICK_AXIS_COUNT; i++) {
+        if (cal->mode == STICK_CALIBRATION_MANUAL) {
+            memset(lut[i], SWITCH_JOYSTICK_MID, STICK_LUT_SIZE);
+        } else {
+            build_axis_lut(lut[i], &cal->entry.axis[i]);
+        }
+    }
+
+    __dmb();
+    cal->lut_sequence = sequence + 1;
+}
+
+// Clear everything but the published tables
+static void reset_state(stick_calibration_t *cal) {
+    memset(&cal->entry, 0, sizeof(*cal) - offsetof(stick_calibration_t, entry));
+}
+
+void stick_calibration_apply(const stick_calibration_t *cal, const int32_t raw[STICK_AXIS_COUNT],
+                             uint8_t out[STICK_AXIS_COUNT]) {
+    uint32_t sequence;
+    do {
+        sequence = cal->lut_sequence;
+        __dmb();
+        const uint8_t (*lut)[STICK_LUT_SIZE] = cal->lut[(sequence >> 1) & 1];
+        for (int i = 0; i < STICK_AXIS_COUNT; i++) {
+            int32_t v = raw[i];
+            if (v < STICK_RAW_MIN) {
+                v = STICK_RAW_MIN;
+            } else if (v > STICK_RAW_MAX) {
+                v = STICK_RAW_MAX;
+            }
+            out[i] = lut[i][v - STICK_RAW_MIN];
+        }
+        __dmb();
+        // The buffer read is rewritten only from the second rebuild on
+    } while (cal->lut_sequence - (sequence & ~1u) > 2);
+}
+
+static void store_slot(int slot) {
+    const btstack_tlv_t *tlv_impl;
+    void *tlv_context;
+    btstack_tlv_get_instance(&tlv_impl, &tlv_context);
+    if (!tlv_impl) {
+        return;
+    }
+    tlv_impl->store_tag(tlv_context, CALIBRATION_TLV_TAG(slot),
+                        (const uint8_t *)&table[slot], sizeof(table[slot]));
+}
+
+// Find the slot for addr, or the least recently used one
+static int find_slot(const bd_addr_t addr) {
+    int lru = 0;
+    for (int i = 0; i < CONFIG_PICONTROLLER_STICK_CALIBRATION_SLOTS; i++) {
+        if (table[i].valid && bd_addr_cmp(table[i].addr, addr) == 0) {
+            return i;
+        }
+        if (!table[i].valid) {
+            if (table[lru].valid) {
+                lru = i;
+            }
+        } else if (table[lru].valid &&
+                   (int16_t)(table[i].last_used - table[lru].last_used) < 0) {
+            lru = i;
+        }
+    }
+    return lru;
+}
+
+void stick_calibration_load(void) {
+    const btstack_tlv_t *tlv_impl;
+    void *tlv_context;
+    btstack_tlv_get_instance(&tlv_impl, &tlv_context);
+
+    memset(table, 0, sizeof(table));
+    use_counter = 0;
+    if (!tlv_impl) {
+        return;
+    }
+
+    for (int i = 0; i < CONFIG_PICONTROLLER_STICK_CALIBRATION_SLOTS; i++) {
+        int size = tlv_impl->get_tag(tlv_context, CALIBRATION_TLV_TAG(i),
+                                     (uint8_t *)&table[i], sizeof(table[i]));
+        if (size != (int)sizeof(table[i])) {
+            memset(&table[i], 0, sizeof(table[i]));
+            continue;
+        }
+        if ((int16_t)(table[i].last_used - use_counter) > 0) {
+            use_counter = table[i].last_used;
+        }
+    }
+}
+
+void stick_calibration_attach(stick_calibration_t *cal, const bd_addr_t addr) {
+    reset_state(cal);
+    cal->mode = STICK_CALIBRATION_AUTO;
+    bd_addr_copy(cal->entry.addr, addr);
+
+#ifdef CONFIG_PICONTROLLER_STICK_CALIBRATION
+    int slot = find_slot(addr);
+    if (table[slot].valid && bd_addr_cmp(table[slot].addr, addr) == 0) {
+        cal->entry = table[slot];
+        logi("stick_calibration: loaded %s from slot %d\n", bd_addr_to_str(addr), slot);
+    } else {
+        for (int i = 0; i < STICK_AXIS_COUNT; i++) {
+            default_axis(&cal->entry.axis[i]);
+        }
+    }
+    for (int i = 0; i < STICK_AXIS_COUNT; i++) {
+        cal->stored_center[i] = cal->entry.axis[i].center;
+    }
+    cal->entry.valid = 1;
+    cal->entry.last_used = ++use_counter;
+#else
+    // Calibration disabled: plain conversion tables, nothing persisted
+    for (int i = 0; i < STICK_AXIS_COUNT; i++) {
+        default_axis(&cal->entry.axis[i]);
+    }
+#endif
+
+    build_luts(cal);
+}
+
+void stick_calibration_attach_nominal(stick_calibration_t *cal) {
+    reset_state(cal);
+    cal->mode = STICK_CALIBRATION_AUTO;
+    cal->center_locked = true;
+    for (int i = 0; i < STICK_AXIS_COUNT; i++) {
+        cal->entry.axis[i].center = 0;
+        cal->entry.axis[i].min = STICK_RAW_MIN;
+        cal->entry.axis[i].max = STICK_RAW_MAX;
+    }
+
+    build_luts(cal);
+}
+
+static bool differs(int32_t a, int32_t b, int32_t step) {
+    return a - b >= step || b - a >= step;
+}
+
+// Write an entry to its slot
+static void save_entry(const stick_calibration_entry_t *entry) {
+    int slot = find_slot(entry->addr);
+    table[slot] = *entry;
+    store_slot(slot);
+
+    logi("stick_calibration: saved %s to slot %d\n", bd_addr_to_str(entry->addr), slot);
+}
+
+void stick_calibration_detach(stick_calibration_t *cal) {
+    if (!cal->entry.valid) {
+        return;
+    }
+    if (cal->save) {
+        // Manual result not stored yet
+        stick_calibration_update(cal);
+    }
+
+    // What is stored now, or the defaults for a controller seen the first time
+    stick_calibration_entry_t stored;
+    int slot = find_slot(cal->entry.addr);
+    bool known = table[slot].valid && bd_addr_cmp(table[slot].addr, cal->entry.addr) == 0;
+    if (known) {
+        stored = table[slot];
+    } else {
+        memset(&stored, 0, sizeof(stored));
+        for (int i = 0; i < STICK_AXIS_COUNT; i++) {
+            default_axis(&stored.axis[i]);
+        }
+    }
+
+    stick_calibration_entry_t next = cal->entry;
+    bool store = false;
+
+    // A center learned on this connection waits as pending until a later
+    // connection learns one that agrees
+    bool agree = cal->center_learned && stored.pending;
+    bool moved = false;
+    for (int i = 0; i < STICK_AXIS_COUNT; i++) {
+        int16_t learned = cal->entry.axis[i].center;
+        agree = agree && !differs(stored.pending_center[i], learned, CENTER_AGREE + 1);
+        moved = moved || (cal->center_learned && differs(learned, cal->stored_center[i], CENTER_AGREE + 1));
+        next.axis[i].center = cal->stored_center[i];
+    }
+    if (agree) {
+        for (int i = 0; i < STICK_AXIS_COUNT; i++) {
+            next.axis[i].center = (int16_t)((stored.pending_center[i] + cal->entry.axis[i].center) / 2);
+        }
+        next.pending = 0;
+        store = true;
+    } else if (moved) {
+        for (int i = 0; i < STICK_AXIS_COUNT; i++) {
+            next.pending_center[i] = cal->entry.axis[i].center;
+        }
+        next.pending = 1;
+        store = true;
+    }
+
+    // Ranges only grow (an incomplete manual calibration does not shrink
+    // them); small growth is kept for this connection only
+    for (int i = 0; i < STICK_AXIS_COUNT; i++) {
+        stick_calibration_axis_t *axis = &next.axis[i];
+        if (stored.axis[i].min < axis->min) {
+            axis->min = stored.axis[i].min;
+        }
+        if (stored.axis[i].max > axis->max) {
+            axis->max = stored.axis[i].max;
+        }
+        store |= differs(axis->min, stored.axis[i].min, STORE_STEP);
+        store |= differs(axis->max, stored.axis[i].max, STORE_STEP);
+    }
+
+    if (store) {
+        save_entry(&next);
+    } else if (known) {
+        table[slot].last_used = cal->entry.last_used;
+    }
+}
+
+#ifdef CONFIG_PICONTROLLER_STICK_CALIBRATION
+
+static bool observe_range(stick_calibration_t *cal, const int32_t axes[STICK_AXIS_COUNT]) {
+    bool manual = cal->mode == STICK_CALIBRATION_MANUAL;
+    bool grew = false;
+
+    for (int i = 0; i < STICK_AXIS_COUNT; i++) {
+        stick_calibration_axis_t *axis = &cal->entry.axis[i];
+        int32_t v = axes[i];
+        if (v < STICK_RAW_MIN) {
+            v = STICK_RAW_MIN;
+        } else if (v > STICK_RAW_MAX) {
+            v = STICK_RAW_MAX;
+        }
+
+        // Small excursions are batched so the tables are not rebuilt per sample
+        if (v > axis->max &&
+            (manual || v - axis->max >= RANGE_REBUILD_STEP || v >= STICK_RAW_MAX)) {
+            axis->max = (int16_t)v;
+            grew = true;
+        } else if (v < axis->min &&
+                   (manual || axis->min - v >= RANGE_REBUILD_STEP || v <= STICK_RAW_MIN)) {
+            axis->min = (int16_t)v;
+            grew = true;
+        }
+    }
+
+    return grew;
+}
+
+static void restart_rest(stick_calibration_t *cal) {
+    cal->rest_count = 0;
+    memset(cal->rest_sum, 0, sizeof(cal->rest_sum));
+}
+
+static bool observe_center(stick_calibration_t *cal, const int32_t axes[STICK_AXIS_COUNT]) {
+    bool at_rest = true;
+
+    for (int i = 0; i < STICK_AXIS_COUNT; i++) {
+        int32_t v = axes[i];
+        int32_t delta = v - cal->prev[i];
+        cal->prev[i] = v;
+
+        if (v < -CENTER_WINDOW || v > CENTER_WINDOW ||
+            delta < -REST_DELTA || delta > REST_DELTA) {
+            at_rest = false;
+        }
+    }
+
+    if (!at_rest) {
+        restart_rest(cal);
+        return false;
+    }
+
+    for (int i = 0; i < STICK_AXIS_COUNT; i++) {
+        int32_t v = axes[i];
+        if (cal->rest_count == 0 || v < cal->rest_min[i]) {
+            cal->rest_min[i] = v;
+        }
+        if (cal->rest_count == 0 || v > cal->rest_max[i]) {
+            cal->rest_max[i] = v;
+        }
+        cal->rest_sum[i] += v;
+    }
+    if (++cal->rest_count < REST_SAMPLES) {
+        return false;
+    }
+
+    // A slow creep passes the per-sample check but not the spread check
+    for (int i = 0; i < STICK_AXIS_COUNT; i++) {
+        if (cal->rest_max[i] - cal->rest_min[i] > REST_SPREAD) {
+            restart_rest(cal);
+            return false;
+        }
+    }
+
+    bool changed = false;
+    for (int i = 0; i < STICK_AXIS_COUNT; i++) {
+        int16_t center = (int16_t)(cal->rest_sum[i] / REST_SAMPLES);
+        if (center != cal->entry.axis[i].center) {
+            cal->entry.axis[i].center = center;
+            changed = true;
+        }
+    }
+    cal->center_locked = true;
+    cal->center_learned = true;
+    return changed;
+}
+
+void stick_calibration_observe(stick_calibration_t *cal, const int32_t axes[STICK_AXIS_COUNT]) {
+    bool stale = observe_range(cal, axes);
+
+    if (cal->mode == STICK_CALIBRATION_MANUAL) {
+        // Tables are rebuilt once the user finishes
+        return;
+    }
+
+    if (!cal->center_locked) {
+        stale |= observe_center(cal, axes);
+    }
+
+    if (stale) {
+        cal->rebuild = true;
+    }
+}
+
+void stick_calibration_update(stick_calibration_t *cal) {
+    if (cal->rebuild) {
+        cal->rebuild = false;
+        build_luts(cal);
+    }
+    if (cal->save) {
+        cal->save = false;
+        save_entry(&cal->entry);
+        for (int i = 0; i < STICK_AXIS_COUNT; i++) {
+            cal->stored_center[i] = cal->entry.axis[i].center;
+        }
+    }
+}
+
+void stick_calibration_begin_manual(stick_calibration_t *cal, const int32_t axes[STICK_AXIS_COUNT]) {
+    for (int i = 0; i < STICK_AXIS_COUNT; i++) {
+        stick_calibration_axis_t *axis = &cal->entry.axis[i];
+        axis->center = (int16_t)axes[i];
+        axis->min = axis->center;
+        axis->max = axis->center;
+    }
+    cal->mode = STICK_CALIBRATION_MANUAL;
+    cal->center_locked = true;
+    cal->center_learned = false;
+    cal->rebuild = true;
+
+    logi("stick_calibration: manual calibration started, rotate both sticks\n");
+}
+
+void stick_calibration_end_manual(stick_calibration_t *cal) {
+    bool valid = true;
+    for (int i = 0; i < STICK_AXIS_COUNT; i++) {
+        stick_calibration_axis_t *axis = &cal->entry.axis[i];
+        if (axis->max - axis->center < MIN_SPAN || axis->center - axis->min < MIN_SPAN) {
+            valid = false;
+        }
+    }
+
+    if (!valid) {
+        // Not enough travel recorded: defaults for this connection, the
+        // stored entry is left alone
+        logi("stick_calibration: manual calibration incomplete, using defaults\n");
+        for (int i = 0; i < STICK_AXIS_COUNT; i++) {
+            default_axis(&cal->entry.axis[i]);
+        }
+        cal->center_locked = false;
+    } else {
+        // Explicit user result: stored as is, replacing any pending center
+        logi("stick_calibration: manual calibration complete\n");
+        cal->entry.pending = 0;
+        cal->save = true;
+    }
+
+    cal->mode = STICK_CALIBRATION_AUTO;
+    cal->rebuild = true;
+}
+
+#else
+
+void stick_calibration_observe(stick_calibration_t *cal, const int32_t axes[STICK_AXIS_COUNT]) {
+    (void)cal;
+    (void)axes;
+}
+
+void stick_calibration_update(stick_calibration_t *cal) {
+    (void)cal;
+}
+
+void stick_calibration_begin_manual(stick_calibration_t *cal, const int32_t axes[STICK_AXIS_COUNT]) {
+    (void)cal;
+    (void)axes;
+}
+
+void stick_calibration_end_manual(stick_calibration_t *cal) {
+    (void)cal;
+}
+
+#endif /* CONFIG_PICONTROLLER_STICK_CALIBRATION */
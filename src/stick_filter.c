@@ -0,0 +1,126 @@
+/*
+ * Adaptive stick smoothing (One-Euro filter) in fixed point
+ *
+ * Per axis and sample:
+ *   dx     = (x - x_hat) / dt                    raw speed
+ *   dx_hat = lowpass(dx, D_CUTOFF)               smoothed speed
+ *   fc     = MIN_CUTOFF + BETA * |dx_hat|        adaptive cutoff
+ *   x_hat  = lowpass(x, fc)
+ *
+ * A one-pole lowpass with cutoff fc sampled every dt has
+ *   alpha = w / (1 + w),  w = 2 * pi * fc * dt
+ * which is computed here as 1 - 1 / (1 + w) with a single 32-bit divide.
+ * Cutoffs are in centi-hertz (cHz) and times in microseconds.
+ */
+
+#include "stick_filter.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "sdkconfig.h"
+
+// 2 * pi * 65536 / 1e8, as 270 / 65536 (error < 0.1%)
+#define W_SCALE 270
+
+// Sample interval limits; anything outside is a reconnect or a burst
+#define MIN_DT_US 250
+#define MAX_DT_US 50000
+
+// Speed clamp (bluepad32 units per second, ~20 full sweeps per second)
+#define MAX_SPEED 20000
+
+static inline uint32_t clamp_u32(uint32_t v, uint32_t lo, uint32_t hi) {
+    if (v < lo) {
+        return lo;
+    }
+    if (v > hi) {
+        return hi;
+    }
+    return v;
+}
+
+// Smoothing factor (Q16) for cutoff fc (cHz) at sample interval dt (us)
+static uint32_t lowpass_alpha_q16(uint32_t cutoff_chz, uint32_t dt_us) {
+    uint32_t w_q16 = (((cutoff_chz * dt_us) >> 8) * W_SCALE) >> 8;
+    return 65536 - (UINT32_MAX / (w_q16 + 65536));
+}
+
+void stick_filter_reset(stick_filter_t *filter) {
+    memset(filter, 0, sizeof(*filter));
+}
+
+void stick_filter_update(stick_filter_t *filter, int32_t axes[STICK_AXIS_COUNT], uint32_t now_us) {
+    if (!filter->primed) {
+        for (int i = 0; i < STICK_AXIS_COUNT; i++) {
+            filter->axis[i].x_q4 = axes[i] * 16;
+            filter->axis[i].dx = 0;
+        }
+        filter->last_us = now_us;
+        filter->primed = true;
+        return;
+    }
+
+    uint32_t dt_us = clamp_u32(now_us - filter->last_us, MIN_DT_US, MAX_DT_US);
+    filter->last_us = now_us;
+
+    int32_t alpha_d_q12 = (int32_t)(lowpass_alpha_q16(CONFIG_PICONTROLLER_STICK_FILTER_D_CUTOFF, dt_us) >> 4);
+
+    for (int i = 0; i < STICK_AXIS_COUNT; i++) {
+        if (!(CONFIG_PICONTROLLER_STICK_FILTER_AXES & (1 << i))) {
+            continue;
+        }
+
+        stick_filter_axis_t *axis = &filter->axis[i];
+        int32_t diff_q4 = axes[i] * 16 - axis->x_q4;
+
+        // Speed estimate in units/s, clamped, then smoothed
+        int32_t dx = (diff_q4 * (int32_t)(1000000 / 16)) / (int32_t)dt_us;
+        if (dx > MAX_SPEED) {
+            dx = MAX_SPEED;
+        } else if (dx < -MAX_SPEED) {
+            dx = -MAX_SPEED;
+        }
+        axis->dx += (alpha_d_q12 * (dx - axis->dx)) >> 12;
+
+        // Adaptive cutoff
+        uint32_t speed = (uint32_t)(axis->dx < 0 ? -axis->dx : axis->dx);
+        uint32_t cutoff = CONFIG_PICONTROLLER_STICK_FILTER_MIN_CUTOFF +
+                          (speed * CONFIG_PICONTROLLER_STICK_FILTER_BETA) / 100;
+        if (cutoff > CONFIG_PICONTROLLER_STICK_FILTER_MAX_CUTOFF) {
+            cutoff = CONFIG_PICONTROLLER_STICK_FILTER_MAX_CUTOFF;
+        }
+
+        int32_t alpha_q16 = (int32_t)lowpass_alpha_q16(cutoff, dt_us);
+        axis->x_q4 += (alpha_q16 * diff_q4) >> 16;
+
+        // Round back to whole units
+        axes[i] = (axis->x_q4 + 8) >> 4;
+    }
+}
+
+uint32_t stick_filter_group_delay_us(uint32_t cutoff_chz, uint32_t interval_us) {
+    // One-pole IIR group delay at DC: T * (1 - alpha) / alpha
+    uint32_t alpha_q16 = lowpass_alpha_q16(cutoff_chz, interval_us);
+    if (alpha_q16 == 0) {
+        return UINT32_MAX;
+    }
+    return (uint32_t)(((uint64_t)interval_us * (65536 - alpha_q16)) / alpha_q16);
+}
+
+void stick_filter_log_config(void) {
+    static const uint32_t intervals_us[] = { 4000, 8000, 15000 };
+
+    printf("stick_filter: min_cutoff=%u cHz beta=%u cHz/(100 u/s) max_cutoff=%u cHz\n",
+           (unsigned)CONFIG_PICONTROLLER_STICK_FILTER_MIN_CUTOFF,
+           (unsigned)CONFIG_PICONTROLLER_STICK_FILTER_BETA,
+           (unsigned)CONFIG_PICONTROLLER_STICK_FILTER_MAX_CUTOFF);
+
+    for (unsigned i = 0; i < sizeof(intervals_us) / sizeof(intervals_us[0]); i++) {
+        uint32_t dt = intervals_us[i];
+        printf("stick_filter: interval %lu us: delay at rest %lu us, at full speed %lu us\n",
+               (unsigned long)dt,
+               (unsigned long)stick_filter_group_delay_us(CONFIG_PICONTROLLER_STICK_FILTER_MIN_CUTOFF, dt),
+               (unsigned long)stick_filter_group_delay_us(CONFIG_PICONTROLLER_STICK_FILTER_MAX_CUTOFF, dt));
+    }
+}
@@ -0,0 +1,131 @@
+/*
+ * Short-horizon stick extrapolation in fixed point
+ *
+ * On each new sample the per-axis speed is measured over the sample
+ * interval and smoothed with weight 1/2^SMOOTH_SHIFT; a direction change
+ * restarts it instead of averaging across the turn. Between samples the
+ * output is
+ *
+ *   pos + speed * min(now - sample, horizon)
+ *
+ * clamped so it never moves further than OVERSHOOT percent of the last
+ * step, never crosses the stick center, and stays inside the axis range.
+ * Samples sitting exactly at center or arriving after a long gap are held
+ * as is, so releases and reconnects are never extrapolated.
+ */
+
+#include "stick_predict.h"
+
+#include "sdkconfig.h"
+
+// Shortest interval treated as a new report (duplicates arrive closer)
+#define MIN_INTERVAL_US 500
+
+// Speed limit (full range per millisecond); with the horizon capped at
+// 16 ms the extrapolation product stays within 32 bits
+#define MAX_VEL_Q8 (SWITCH_JOYSTICK_MAX << 8)
+#define MAX_HORIZON_US 16000
+
+static uint8_t *axis_value(SwitchOutReport *report, int axis) {
+    switch (axis) {
+        case 0:
+            return &report->lx;
+        case 1:
+            return &report->ly;
+        case 2:
+            return &report->rx;
+        default:
+            return &report->ry;
+    }
+}
+
+void stick_predict_reset(stick_predict_t *predict, uint32_t horizon_us) {
+    for (int i = 0; i < STICK_PREDICT_AXES; i++) {
+        predict->axis[i].pos_q8 = SWITCH_JOYSTICK_MID << 8;
+        predict->axis[i].step_q8 = 0;
+        predict->axis[i].vel_q8 = 0;
+    }
+    predict->sample_us = 0;
+    predict->horizon_us = horizon_us > MAX_HORIZON_US ? MAX_HORIZON_US : horizon_us;
+    predict->primed = false;
+}
+
+static void observe(stick_predict_axis_t *axis, int32_t pos_q8, uint32_t interval_us, bool valid) {
+    if (!valid || pos_q8 == (SWITCH_JOYSTICK_MID << 8)) {
+        axis->step_q8 = 0;
+        axis->vel_q8 = 0;
+        axis->pos_q8 = pos_q8;
+        return;
+    }
+
+    int32_t step = pos_q8 - axis->pos_q8;
+    int32_t vel = step * 1000 / (int32_t)interval_us;
+    if (vel > MAX_VEL_Q8) {
+        vel = MAX_VEL_Q8;
+    } else if (vel < -MAX_VEL_Q8) {
+        vel = -MAX_VEL_Q8;
+    }
+
+    if ((vel ^ axis->vel_q8) < 0 || axis->vel_q8 == 0) {
+        // Direction change or start of motion
+        axis->vel_q8 = vel;
+    } else {
+        axis->vel_q8 += (vel - axis->vel_q8) >> CONFIG_PICONTROLLER_STICK_PREDICT_SMOOTH_SHIFT;
+    }
+    axis->step_q8 = step;
+    axis->pos_q8 = pos_q8;
+}
+
+static uint8_t extrapolate(const stick_predict_axis_t *axis, uint32_t ahead_us) {
+    int32_t delta = axis->vel_q8 * (int32_t)ahead_us / 1000;
+
+    // Never further than the last step, and only in its direction
+    int32_t limit = axis->step_q8 * CONFIG_PICONTROLLER_STICK_PREDICT_OVERSHOOT / 100;
+    if (limit >= 0) {
+        delta = delta < 0 ? 0 : (delta > limit ? limit : delta);
+    } else {
+        delta = delta > 0 ? 0 : (delta < limit ? limit : delta);
+    }
+
+    int32_t out = axis->pos_q8 + delta;
+
+    // Never cross the center
+    const int32_t mid = SWITCH_JOYSTICK_MID << 8;
+    if ((axis->pos_q8 > mid && out < mid) || (axis->pos_q8 < mid && out > mid)) {
+        out = mid;
+    }
+
+    out = (out + 128) >> 8;
+    if (out < SWITCH_JOYSTICK_MIN) {
+        out = SWITCH_JOYSTICK_MIN;
+    } else if (out > SWITCH_JOYSTICK_MAX) {
+        out = SWITCH_JOYSTICK_MAX;
+    }
+    return (uint8_t)out;
+}
+
+void stick_predict_apply(stick_predict_t *predict, uint32_t sample_us, uint32_t now_us, SwitchOutReport *report) {
+    if (!predict->primed || sample_us != predict->sample_us) {
+        uint32_t interval_us = sample_us - predict->sample_us;
+        bool valid = predict->primed && interval_us >= MIN_INTERVAL_US &&
+                     interval_us <= CONFIG_PICONTROLLER_STICK_PREDICT_MAX_GAP_US;
+
+        for (int i = 0; i < STICK_PREDICT_AXES; i++) {
+            observe(&predict->axis[i], (int32_t)*axis_value(report, i) << 8, interval_us, valid);
+        }
+        predict->sample_us = sample_us;
+        predict->primed = true;
+    }
+
+    // A sample stamped just after now_us is not ahead of anything yet
+    uint32_t ahead_us = now_us - sample_us;
+    if ((int32_t)ahead_us < 0) {
+        ahead_us = 0;
+    } else if (ahead_us > predict->horizon_us) {
+        ahead_us = predict->horizon_us;
+    }
+
+    for (int i = 0; i < STICK_PREDICT_AXES; i++) {
+        *axis_value(report, i) = extrapolate(&predict->axis[i], ahead_us);
+    }
+}
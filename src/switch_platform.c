@@ -8,25 +8,64 @@
 
 #include <pico/cyw43_arch.h>
 #include <pico/multicore.h>
+#include <pico/time.h>
 #include <uni.h>
 
 #include "sdkconfig.h"
+#include "bench.h"
+#include "fast_parse.h"
+#include "inject.h"
+#include "kbm.h"
+#include "link_health.h"
 #include "report.h"
+#include "stick_calibration.h"
+#include "stick_filter.h"
 #include "switch_descriptors.h"
+#include "translate.h"
 
 // Sanity check
 #ifndef CONFIG_BLUEPAD32_PLATFORM_CUSTOM
 #error "Pico W must use BLUEPAD32_PLATFORM_CUSTOM"
 #endif
+#if defined(CONFIG_PICONTROLLER_FAST_PARSE_VERIFY) && !defined(CONFIG_PICONTROLLER_FAST_PARSE)
+#error "CONFIG_PICONTROLLER_FAST_PARSE_VERIFY needs CONFIG_PICONTROLLER_FAST_PARSE"
+#endif
 
-// Deadzone for analog sticks to prevent drift
-#define AXIS_DEADZONE 0x0a
+// Print benchmarks every N controller reports
+#define BENCH_REPORT_INTERVAL 1000
 
 // Current gamepad report
 static SwitchOutReport current_report;
 
-// Controller connection state
-static bool controller_connected = false;
+// Number of connected controllers
+static uint8_t controllers_connected = 0;
+static bool pad_ready[CONFIG_BLUEPAD32_MAX_DEVICES];
+
+// Per-controller calibration and axis lookup tables
+static stick_calibration_t stick_calibration[GAMEPAD_SLOTS];
+
+// Manual calibration chord (MINUS + PLUS) tracking
+#define CALIBRATION_CHORD (MISC_BUTTON_BACK | MISC_BUTTON_HOME)
+static uint32_t calibration_chord_start_us[GAMEPAD_SLOTS];
+static bool calibration_chord_latched[GAMEPAD_SLOTS];
+
+#ifdef CONFIG_PICONTROLLER_STICK_CALIBRATION
+// Table rebuilds and flash writes run from here, not from the report path
+#define CALIBRATION_UPDATE_MS 50
+static btstack_timer_source_t calibration_timer;
+#endif
+
+// Bumped on every connect so the translating core resets its per-pad state
+static uint8_t pad_epoch[GAMEPAD_SLOTS];
+
+// Current controller sample
+static raw_sample_t current_sample;
+
+// Time spent in the controller data callback (Core 1)
+static bench_stat_t callback_bench = BENCH_STAT_INIT("bt_callback");
+
+// Periodic proof of life for Core 0 (stale input protection)
+static btstack_timer_source_t heartbeat_timer;
 
 
 //
@@ -42,122 +81,336 @@ static void empty_gamepad_report(SwitchOutReport *report) {
     report->ry = SWITCH_JOYSTICK_MID;
 }
 
-static uint8_t convert_to_switch_axis(int32_t bluepad_axis) {
-    // bluepad32 reports from -512 to 511 as int32_t
-    // Switch reports from 0 to 255 as uint8_t (mid = 0x80)
+#ifdef CONFIG_PICONTROLLER_STICK_CALIBRATION
+// Toggle manual calibration when MINUS + PLUS are held long enough
+static void update_calibration_chord(int idx, uint8_t misc_buttons, const int32_t axes[STICK_AXIS_COUNT]) {
+    if ((misc_buttons & CALIBRATION_CHORD) != CALIBRATION_CHORD) {
+        calibration_chord_start_us[idx] = 0;
+        calibration_chord_latched[idx] = false;
+        return;
+    }
 
-    bluepad_axis += 513;  // now range is 1 to 1024
-    bluepad_axis /= 4;    // now range is 0 to 256
+    uint32_t now = time_us_32();
+    if (calibration_chord_start_us[idx] == 0) {
+        calibration_chord_start_us[idx] = now | 1;
+        return;
+    }
+    if (calibration_chord_latched[idx] ||
+        now - calibration_chord_start_us[idx] < CONFIG_PICONTROLLER_STICK_CALIBRATION_HOLD_MS * 1000u) {
+        return;
+    }
 
-    if (bluepad_axis < SWITCH_JOYSTICK_MIN) {
-        bluepad_axis = SWITCH_JOYSTICK_MIN;
-    } else if ((bluepad_axis > (SWITCH_JOYSTICK_MID - AXIS_DEADZONE)) &&
-               (bluepad_axis < (SWITCH_JOYSTICK_MID + AXIS_DEADZONE))) {
-        // Apply deadzone - center the stick
-        bluepad_axis = SWITCH_JOYSTICK_MID;
-    } else if (bluepad_axis > SWITCH_JOYSTICK_MAX) {
-        bluepad_axis = SWITCH_JOYSTICK_MAX;
+    calibration_chord_latched[idx] = true;
+    stick_calibration_t *cal = &stick_calibration[idx];
+    if (cal->mode == STICK_CALIBRATION_MANUAL) {
+        stick_calibration_end_manual(cal);
+    } else {
+        stick_calibration_begin_manual(cal, axes);
     }
+}
+#endif
 
-    return (uint8_t)bluepad_axis;
+// Clear per-pad processing state for a newly connected controller
+static void reset_pad_state(int idx) {
+    calibration_chord_start_us[idx] = 0;
+    calibration_chord_latched[idx] = false;
+    pad_epoch[idx]++;
 }
 
-static void fill_gamepad_report(uni_gamepad_t *gp) {
-    empty_gamepad_report(&current_report);
+// Publish the current sample to the pad's slot, either raw (translated on
+// Core 0) or as a finished report; start is the bench time of its arrival
+static void process_sample(int idx, uint32_t start) {
+#ifdef CONFIG_PICONTROLLER_STICK_TRACE
+    // Input for tools/stick_predict_eval.c
+    printf("trace: %d %lu %d %d %d %d\n", idx, (unsigned long)current_sample.timestamp_us,
+           current_sample.axes[0], current_sample.axes[1], current_sample.axes[2], current_sample.axes[3]);
+#endif
 
-    // Face buttons
-    if (gp->buttons & BUTTON_A) {
-        current_report.buttons |= SWITCH_MASK_A;
+#ifdef CONFIG_PICONTROLLER_STICK_CALIBRATION
+    // Learn from the unfiltered values so the true extremes are seen
+    int32_t axes[STICK_AXIS_COUNT];
+    for (int i = 0; i < STICK_AXIS_COUNT; i++) {
+        axes[i] = current_sample.axes[i];
     }
-    if (gp->buttons & BUTTON_B) {
-        current_report.buttons |= SWITCH_MASK_B;
+    update_calibration_chord(idx, current_sample.misc_buttons, axes);
+    stick_calibration_observe(&stick_calibration[idx], axes);
+
+    // The chord belongs to calibration, the console never sees it
+    if ((current_sample.misc_buttons & CALIBRATION_CHORD) == CALIBRATION_CHORD) {
+        current_sample.misc_buttons &= (uint8_t)~CALIBRATION_CHORD;
     }
-    if (gp->buttons & BUTTON_X) {
-        current_report.buttons |= SWITCH_MASK_X;
+#endif
+
+#ifdef CONFIG_PICONTROLLER_RAW_HANDOFF
+    set_global_gamepad_sample(idx, &current_sample);
+#else
+    translate_pad(idx, &current_sample, &current_report);
+    set_global_gamepad_report(idx, &current_report);
+#endif
+
+    bench_stop(&callback_bench, start);
+    if (callback_bench.count >= BENCH_REPORT_INTERVAL) {
+        bench_print(&callback_bench);
     }
-    if (gp->buttons & BUTTON_Y) {
-        current_report.buttons |= SWITCH_MASK_Y;
+}
+
+#ifdef CONFIG_PICONTROLLER_FAST_PARSE_VERIFY
+// Compare the fast-path sample for this report with bluepad32's result
+static void verify_fast_sample(int idx);
+#endif
+
+// Capture one bluepad32 gamepad state and publish it
+static void process_gamepad(int idx, uni_gamepad_t *gp) {
+    uint32_t start = bench_start();
+    translate_fill_sample(&current_sample, gp, pad_epoch[idx], time_us_32());
+#ifdef CONFIG_PICONTROLLER_FAST_PARSE_VERIFY
+    verify_fast_sample(idx);
+#endif
+    process_sample(idx, start);
+}
+
+#ifdef CONFIG_PICONTROLLER_INJECT
+// Virtual controllers fed from the UART (see inject.h). They use the
+// slots after the Bluetooth ones, so a real pad's calibration and report
+// slot are never touched.
+static bool pad_injected[CONFIG_PICONTROLLER_INJECT_SLOTS];
+
+static void inject_gamepad(uint8_t slot, uni_gamepad_t *gp) {
+    uint8_t idx = CONFIG_BLUEPAD32_MAX_DEVICES + slot;
+
+    if (!gp) {
+        if (pad_injected[slot]) {
+            pad_injected[slot] = false;
+            empty_gamepad_report(&current_report);
+            set_global_gamepad_report(idx, &current_report);
+            set_global_gamepad_active(idx, false);
+            logi("switch_platform: virtual controller %u removed\n", slot);
+        }
+        return;
     }
 
-    // Shoulder buttons
-    if (gp->buttons & BUTTON_SHOULDER_L) {
-        current_report.buttons |= SWITCH_MASK_L;
+    if (!pad_injected[slot]) {
+        pad_injected[slot] = true;
+        stick_calibration_attach_nominal(&stick_calibration[idx]);
+        reset_pad_state(idx);
+        set_global_gamepad_deadline(idx, 0);
+        set_global_gamepad_active(idx, true);
+        logi("switch_platform: virtual controller %u added\n", slot);
     }
-    if (gp->buttons & BUTTON_SHOULDER_R) {
-        current_report.buttons |= SWITCH_MASK_R;
+
+    process_gamepad(idx, gp);
+}
+#endif
+
+static int get_pad_index(uni_hid_device_t *d) {
+    int idx = uni_hid_device_get_idx_for_instance(d);
+    if (idx < 0 || idx >= CONFIG_BLUEPAD32_MAX_DEVICES) {
+        return -1;
     }
+    return idx;
+}
 
-    // D-pad
-    switch (gp->dpad) {
-        case DPAD_UP:
-            current_report.hat = SWITCH_HAT_UP;
-            break;
-        case DPAD_DOWN:
-            current_report.hat = SWITCH_HAT_DOWN;
-            break;
-        case DPAD_LEFT:
-            current_report.hat = SWITCH_HAT_LEFT;
-            break;
-        case DPAD_RIGHT:
-            current_report.hat = SWITCH_HAT_RIGHT;
-            break;
-        case DPAD_UP | DPAD_RIGHT:
-            current_report.hat = SWITCH_HAT_UPRIGHT;
-            break;
-        case DPAD_DOWN | DPAD_RIGHT:
-            current_report.hat = SWITCH_HAT_DOWNRIGHT;
-            break;
-        case DPAD_DOWN | DPAD_LEFT:
-            current_report.hat = SWITCH_HAT_DOWNLEFT;
-            break;
-        case DPAD_UP | DPAD_LEFT:
-            current_report.hat = SWITCH_HAT_UPLEFT;
-            break;
+static void update_led_status(void) {
+    cyw43_arch_gpio_put(CYW43_WL_GPIO_LED_PIN, controllers_connected > 0 ? 1 : 0);
+}
+
+// Pads that send input reports continuously, even when nothing changes;
+// only these can be caught going silent by a report deadline
+static bool streams_reports(const uni_hid_device_t *d) {
+    switch (d->controller_type) {
+        case CONTROLLER_TYPE_PS3Controller:
+        case CONTROLLER_TYPE_PS4Controller:
+        case CONTROLLER_TYPE_PS5Controller:
+        case CONTROLLER_TYPE_SwitchProController:
+        case CONTROLLER_TYPE_SwitchJoyConLeft:
+        case CONTROLLER_TYPE_SwitchJoyConRight:
+            return true;
         default:
-            current_report.hat = SWITCH_HAT_NOTHING;
-            break;
+            return false;
     }
+}
+
+#ifdef CONFIG_PICONTROLLER_FAST_PARSE
+// Raw input reports of known pads are decoded by fast_parse.c and
+// published from here; bluepad32's own parser (saved per pad) handles
+// every report the fast path declines. With VERIFY both run on every
+// report and the results are compared instead; with BENCH as well, the
+// cycles of both parsers are logged for the first reports.
+typedef void (*parse_input_report_fn_t)(uni_hid_device_t *d, const uint8_t *report, uint16_t len);
+
+static parse_input_report_fn_t generic_parser[CONFIG_BLUEPAD32_MAX_DEVICES];
+static fast_parse_fn_t fast_parser[CONFIG_BLUEPAD32_MAX_DEVICES];
+
+// Last report of the pad was published by the fast path, so the
+// bluepad32 callback that follows carries nothing new
+static bool fast_parsed[CONFIG_BLUEPAD32_MAX_DEVICES];
+
+static bench_stat_t fast_parse_bench = BENCH_STAT_INIT("parse_fast");
+static bench_stat_t generic_parse_bench = BENCH_STAT_INIT("parse_generic");
+
+#ifdef CONFIG_PICONTROLLER_FAST_PARSE_VERIFY
+// Log every N compared reports
+#define VERIFY_LOG_INTERVAL 1000
+// Log at most this many individual mismatches
+#define VERIFY_LOG_MISMATCHES 16
+// Log the cycles of both parsers for this many reports (with BENCH)
+#define VERIFY_LOG_CYCLES 64
+
+static raw_sample_t fast_sample[CONFIG_BLUEPAD32_MAX_DEVICES];
+static bool fast_sample_pending[CONFIG_BLUEPAD32_MAX_DEVICES];
+static uint32_t verify_count;
+static uint32_t verify_mismatches;
+static uint32_t verify_cycles_logged;
+#endif
 
-    // Analog sticks
-    current_report.lx = convert_to_switch_axis(gp->axis_x);
-    current_report.ly = convert_to_switch_axis(gp->axis_y);
-    current_report.rx = convert_to_switch_axis(gp->axis_rx);
-    current_report.ry = convert_to_switch_axis(gp->axis_ry);
+// Same A/B and X/Y swap bluepad32 applies through uni_gamepad_set_mappings()
+static uint16_t swap_face_buttons(uint16_t buttons) {
+    uint16_t swapped = buttons & ~(BUTTON_A | BUTTON_B | BUTTON_X | BUTTON_Y);
+    swapped |= (buttons & BUTTON_A) ? BUTTON_B : 0;
+    swapped |= (buttons & BUTTON_B) ? BUTTON_A : 0;
+    swapped |= (buttons & BUTTON_X) ? BUTTON_Y : 0;
+    swapped |= (buttons & BUTTON_Y) ? BUTTON_X : 0;
+    return swapped;
+}
 
-    // Thumb buttons (L3/R3)
-    if (gp->buttons & BUTTON_THUMB_L) {
-        current_report.buttons |= SWITCH_MASK_L3;
+static void print_parse_benches(void) {
+    if (fast_parse_bench.count + generic_parse_bench.count >= BENCH_REPORT_INTERVAL) {
+        bench_print(&fast_parse_bench);
+        bench_print(&generic_parse_bench);
     }
-    if (gp->buttons & BUTTON_THUMB_R) {
-        current_report.buttons |= SWITCH_MASK_R3;
+}
+
+static void fast_parse_input_report(uni_hid_device_t *d, const uint8_t *report, uint16_t len) {
+    int idx = get_pad_index(d);
+    if (idx < 0 || !generic_parser[idx]) {
+        return;
     }
 
-    // Triggers (ZL/ZR) - check both analog and digital
-    if (gp->brake || (gp->buttons & BUTTON_TRIGGER_L)) {
-        current_report.buttons |= SWITCH_MASK_ZL;
+    uint32_t start = bench_start();
+#ifdef CONFIG_PICONTROLLER_FAST_PARSE_VERIFY
+    uint32_t fast_cycles = 0;
+    fast_sample_pending[idx] = fast_parser[idx](report, len, &fast_sample[idx]);
+    if (fast_sample_pending[idx]) {
+        fast_cycles = bench_stop(&fast_parse_bench, start);
     }
-    if (gp->throttle || (gp->buttons & BUTTON_TRIGGER_R)) {
-        current_report.buttons |= SWITCH_MASK_ZR;
+#else
+    if (fast_parser[idx](report, len, &current_sample)) {
+        current_sample.buttons = swap_face_buttons(current_sample.buttons);
+        current_sample.timestamp_us = time_us_32();
+        current_sample.epoch = pad_epoch[idx];
+        bench_stop(&fast_parse_bench, start);
+        print_parse_benches();
+
+        fast_parsed[idx] = true;
+        link_health_report(idx);
+        process_sample(idx, start);
+        return;
+    }
+    fast_parsed[idx] = false;
+#endif
+
+    start = bench_start();
+    generic_parser[idx](d, report, len);
+#ifdef CONFIG_PICONTROLLER_FAST_PARSE_VERIFY
+    uint32_t generic_cycles = bench_stop(&generic_parse_bench, start);
+    // Same raw report through both parsers; the counts are zero without BENCH
+    if (fast_sample_pending[idx] && generic_cycles != 0 && verify_cycles_logged < VERIFY_LOG_CYCLES) {
+        verify_cycles_logged++;
+        logi("fast_parse: pad %d report 0x%02x len %u cycles fast %lu generic %lu\n", idx, report[0],
+             (unsigned)len, (unsigned long)fast_cycles, (unsigned long)generic_cycles);
     }
+#else
+    bench_stop(&generic_parse_bench, start);
+#endif
+    print_parse_benches();
+}
 
-    // Misc buttons
-    if (gp->misc_buttons & MISC_BUTTON_SYSTEM) {
-        current_report.buttons |= SWITCH_MASK_HOME;
+#ifdef CONFIG_PICONTROLLER_FAST_PARSE_VERIFY
+static void verify_fast_sample(int idx) {
+    if (idx >= CONFIG_BLUEPAD32_MAX_DEVICES || !fast_sample_pending[idx]) {
+        return;
     }
-    if (gp->misc_buttons & MISC_BUTTON_CAPTURE) {
-        current_report.buttons |= SWITCH_MASK_CAPTURE;
+    fast_sample_pending[idx] = false;
+
+    const raw_sample_t *f = &fast_sample[idx];
+    const raw_sample_t *g = &current_sample;
+    const char *field = NULL;
+    int32_t fast_value = 0;
+    int32_t generic_value = 0;
+
+#define VERIFY_FIELD(name, a, b)          \
+    if (!field && (a) != (b)) {           \
+        field = (name);                   \
+        fast_value = (a);                 \
+        generic_value = (b);              \
     }
-    if (gp->misc_buttons & MISC_BUTTON_BACK) {
-        current_report.buttons |= SWITCH_MASK_MINUS;
+    VERIFY_FIELD("buttons", swap_face_buttons(f->buttons), g->buttons);
+    VERIFY_FIELD("dpad", f->dpad, g->dpad);
+    VERIFY_FIELD("misc", f->misc_buttons, g->misc_buttons);
+    VERIFY_FIELD("x", f->axes[0], g->axes[0]);
+    VERIFY_FIELD("y", f->axes[1], g->axes[1]);
+    VERIFY_FIELD("rx", f->axes[2], g->axes[2]);
+    VERIFY_FIELD("ry", f->axes[3], g->axes[3]);
+    VERIFY_FIELD("brake", f->brake, g->brake);
+    VERIFY_FIELD("throttle", f->throttle, g->throttle);
+    VERIFY_FIELD("gyro0", f->gyro[0], g->gyro[0]);
+    VERIFY_FIELD("gyro1", f->gyro[1], g->gyro[1]);
+    VERIFY_FIELD("gyro2", f->gyro[2], g->gyro[2]);
+#undef VERIFY_FIELD
+
+    verify_count++;
+    if (field) {
+        verify_mismatches++;
+        if (verify_mismatches <= VERIFY_LOG_MISMATCHES) {
+            logi("fast_parse: pad %d %s fast %ld generic %ld\n", idx, field, (long)fast_value,
+                 (long)generic_value);
+        }
     }
-    if (gp->misc_buttons & MISC_BUTTON_HOME) {
-        current_report.buttons |= SWITCH_MASK_PLUS;
+    if (verify_count % VERIFY_LOG_INTERVAL == 0) {
+        logi("fast_parse: %lu of %lu reports differ from bluepad32\n", (unsigned long)verify_mismatches,
+             (unsigned long)verify_count);
     }
 }
+#endif
 
-static void update_led_status(void) {
-    cyw43_arch_gpio_put(CYW43_WL_GPIO_LED_PIN, controller_connected ? 1 : 0);
+// Put the fast path in front of bluepad32's parser for supported pads
+static void attach_fast_parser(int idx, uni_hid_device_t *d) {
+    fast_parsed[idx] = false;
+    if (d->report_parser.parse_input_report == fast_parse_input_report) {
+        return;
+    }
+
+    const char *name = NULL;
+    fast_parse_fn_t parser = NULL;
+    switch (d->controller_type) {
+        case CONTROLLER_TYPE_PS4Controller:
+            name = "DualShock 4";
+            parser = (CONFIG_PICONTROLLER_FAST_PARSE_PADS & FAST_PARSE_DS4) ? fast_parse_ds4 : NULL;
+            break;
+        case CONTROLLER_TYPE_PS5Controller:
+            name = "DualSense";
+            parser = (CONFIG_PICONTROLLER_FAST_PARSE_PADS & FAST_PARSE_DS5) ? fast_parse_ds5 : NULL;
+            break;
+        case CONTROLLER_TYPE_XBoxOneController:
+            name = "Xbox Wireless";
+            parser = (CONFIG_PICONTROLLER_FAST_PARSE_PADS & FAST_PARSE_XBOX) ? fast_parse_xbox : NULL;
+            break;
+        default:
+            break;
+    }
+
+    // Pads parsed from their HID descriptor have no report hook to wrap
+    generic_parser[idx] = d->report_parser.parse_input_report;
+    if (!parser || !generic_parser[idx]) {
+        fast_parser[idx] = NULL;
+        return;
+    }
+
+    fast_parser[idx] = parser;
+    d->report_parser.parse_input_report = fast_parse_input_report;
+    logi("switch_platform: pad %d uses the fast %s parser\n", idx, name);
 }
+#endif
 
 //
 // Platform Overrides
@@ -169,7 +422,17 @@ static void switch_platform_init(int argc, const char **argv) {
 
     logi("switch_platform: init()\n");
 
-    controller_connected = false;
+    controllers_connected = 0;
+    memset(pad_ready, 0, sizeof(pad_ready));
+#ifdef CONFIG_PICONTROLLER_INJECT
+    memset(pad_injected, 0, sizeof(pad_injected));
+#endif
+
+#ifdef CONFIG_PICONTROLLER_STICK_FILTER
+    stick_filter_log_config();
+#endif
+
+    translate_init(stick_calibration);
 
     // Set up button mappings for Switch layout
     // Swap A/B and X/Y to match Nintendo convention
@@ -180,14 +443,36 @@ static void switch_platform_init(int argc, const char **argv) {
     mappings.button_x = UNI_GAMEPAD_MAPPINGS_BUTTON_Y;
     uni_gamepad_set_mappings(&mappings);
 
-    // Initialize report with neutral values
+    // Initialize slots with neutral values
     empty_gamepad_report(&current_report);
-    set_global_gamepad_report(&current_report);
+    for (uint8_t i = 0; i < GAMEPAD_SLOTS; i++) {
+        set_global_gamepad_active(i, false);
+        set_global_gamepad_report(i, &current_report);
+    }
+}
+
+static void heartbeat_handler(btstack_timer_source_t *ts) {
+    set_global_heartbeat();
+    btstack_run_loop_set_timer(ts, CONFIG_PICONTROLLER_HEARTBEAT_MS);
+    btstack_run_loop_add_timer(ts);
+}
+
+#ifdef CONFIG_PICONTROLLER_STICK_CALIBRATION
+static void calibration_handler(btstack_timer_source_t *ts) {
+    for (int i = 0; i < GAMEPAD_SLOTS; i++) {
+        stick_calibration_update(&stick_calibration[i]);
+    }
+    btstack_run_loop_set_timer(ts, CALIBRATION_UPDATE_MS);
+    btstack_run_loop_add_timer(ts);
 }
+#endif
 
 static void switch_platform_on_init_complete(void) {
     logi("switch_platform: on_init_complete()\n");
 
+    // Stored stick calibrations (TLV store is ready now)
+    stick_calibration_load();
+
     // Start scanning for controllers and auto-connect
     uni_bt_start_scanning_and_autoconnect_unsafe();
 
@@ -199,6 +484,21 @@ static void switch_platform_on_init_complete(void) {
 
     logi("switch_platform: ready for controller connection\n");
 
+#ifdef CONFIG_PICONTROLLER_INJECT
+    inject_start(inject_gamepad);
+#endif
+
+    link_health_start();
+
+#ifdef CONFIG_PICONTROLLER_STICK_CALIBRATION
+    btstack_run_loop_set_timer_handler(&calibration_timer, calibration_handler);
+    calibration_handler(&calibration_timer);
+#endif
+
+    // Heartbeat only runs while the BTstack run loop does
+    btstack_run_loop_set_timer_handler(&heartbeat_timer, heartbeat_handler);
+    heartbeat_handler(&heartbeat_timer);
+
     // Signal USB core that Bluetooth is ready
     multicore_fifo_push_blocking(0);
 }
@@ -211,34 +511,77 @@ static uni_error_t switch_platform_on_device_discovered(bd_addr_t addr,
     ARG_UNUSED(name);
     ARG_UNUSED(rssi);
 
-    // Filter out keyboards and mice - only accept gamepads
+#ifndef CONFIG_PICONTROLLER_KBM
+    // Filter out keyboards - only accept gamepads
     if (((cod & UNI_BT_COD_MINOR_MASK) & UNI_BT_COD_MINOR_KEYBOARD) == UNI_BT_COD_MINOR_KEYBOARD) {
         logi("switch_platform: ignoring keyboard\n");
         return UNI_ERROR_IGNORE_DEVICE;
     }
+#else
+    ARG_UNUSED(cod);
+#endif
 
     return UNI_ERROR_SUCCESS;
 }
 
 static void switch_platform_on_device_connected(uni_hid_device_t *d) {
     logi("switch_platform: device connected: %p\n", d);
+
+    int idx = get_pad_index(d);
+    if (idx < 0) {
+        return;
+    }
+
+    stick_calibration_attach(&stick_calibration[idx], d->conn.btaddr);
+    reset_pad_state(idx);
+    link_health_connected(idx, d->conn.handle);
 }
 
 static void switch_platform_on_device_disconnected(uni_hid_device_t *d) {
     logi("switch_platform: device disconnected: %p\n", d);
 
-    // Reset report to neutral on disconnect
+    int idx = get_pad_index(d);
+    if (idx < 0) {
+        return;
+    }
+
+    stick_calibration_detach(&stick_calibration[idx]);
+    link_health_disconnected(idx);
+#ifdef CONFIG_PICONTROLLER_FAST_PARSE
+    generic_parser[idx] = NULL;
+    fast_parsed[idx] = false;
+#endif
+
+    // Reset slot to neutral and drop it from the merge
     empty_gamepad_report(&current_report);
-    set_global_gamepad_report(&current_report);
+    set_global_gamepad_report(idx, &current_report);
+    set_global_gamepad_active(idx, false);
 
-    controller_connected = false;
+    if (pad_ready[idx]) {
+        pad_ready[idx] = false;
+        controllers_connected--;
+    }
     update_led_status();
 }
 
 static uni_error_t switch_platform_on_device_ready(uni_hid_device_t *d) {
     logi("switch_platform: device ready: %p\n", d);
 
-    controller_connected = true;
+    int idx = get_pad_index(d);
+    if (idx < 0) {
+        return UNI_ERROR_SUCCESS;
+    }
+
+#ifdef CONFIG_PICONTROLLER_FAST_PARSE
+    attach_fast_parser(idx, d);
+#endif
+
+    set_global_gamepad_deadline(idx, streams_reports(d) ? CONFIG_PICONTROLLER_STALE_INPUT_MS : 0);
+    set_global_gamepad_active(idx, true);
+    if (!pad_ready[idx]) {
+        pad_ready[idx] = true;
+        controllers_connected++;
+    }
     update_led_status();
 
     return UNI_ERROR_SUCCESS;
@@ -246,17 +589,40 @@ static uni_error_t switch_platform_on_device_ready(uni_hid_device_t *d) {
 
 static void switch_platform_on_controller_data(uni_hid_device_t *d,
                                                 uni_controller_t *ctl) {
-    ARG_UNUSED(d);
+    int idx = get_pad_index(d);
+    if (idx < 0) {
+        return;
+    }
+
+#ifdef CONFIG_PICONTROLLER_FAST_PARSE
+    // Already published from the raw report
+    if (fast_parsed[idx]) {
+        return;
+    }
+#endif
+
+    link_health_report(idx);
+
+#ifdef CONFIG_PICONTROLLER_KBM
+    // Keyboard and mouse feed their own slot; the merge combines them
+    if (ctl->klass == UNI_CONTROLLER_CLASS_KEYBOARD) {
+        kbm_fill_keyboard_report(&ctl->keyboard, &current_report);
+        set_global_gamepad_report(idx, &current_report);
+        return;
+    }
+    if (ctl->klass == UNI_CONTROLLER_CLASS_MOUSE) {
+        kbm_fill_mouse_report(&ctl->mouse, &current_report);
+        set_global_gamepad_report(idx, &current_report);
+        return;
+    }
+#endif
 
     // Only process gamepad data
     if (ctl->klass != UNI_CONTROLLER_CLASS_GAMEPAD) {
         return;
     }
 
-    uni_gamepad_t *gp = &ctl->gamepad;
-
-    fill_gamepad_report(gp);
-    set_global_gamepad_report(&current_report);
+    process_gamepad(idx, &ctl->gamepad);
 }
 
 static const uni_property_t *switch_platform_get_property(uni_property_idx_t idx) {
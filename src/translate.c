@@ -0,0 +1,207 @@
+/*
+ * Controller sample to Switch report translation
+ *
+ * Stick smoothing and motion aim keep per-pad state. It is owned by the
+ * translating core and reset lazily when a sample carries a new epoch,
+ * so connect events on Core 1 never touch it directly. Calibration
+ * tables stay owned by Core 1 (learning and flash persistence); they are
+ * only read here, through stick_calibration_apply(), which copes with a
+ * rebuild running on the other core.
+ */
+
+#include "translate.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "sdkconfig.h"
+#include "bench.h"
+#include "motion_aim.h"
+#include "report.h"
+#include "stick_filter.h"
+
+// Print benchmarks every N translated samples
+#define BENCH_REPORT_INTERVAL 1000
+
+typedef struct {
+    uint8_t epoch;
+    bool started;
+#ifdef CONFIG_PICONTROLLER_STICK_FILTER
+    stick_filter_t filter;
+#endif
+#ifdef CONFIG_PICONTROLLER_MOTION_AIM
+    motion_aim_t aim;
+#endif
+} translate_state_t;
+
+static const stick_calibration_t *pad_calibration;
+static translate_state_t pad_state[GAMEPAD_SLOTS];
+
+#ifdef CONFIG_PICONTROLLER_STICK_FILTER
+static bench_stat_t stick_filter_bench = BENCH_STAT_INIT("stick_filter");
+#endif
+#ifdef CONFIG_PICONTROLLER_MOTION_AIM
+static bench_stat_t motion_aim_bench = BENCH_STAT_INIT("motion_aim");
+#endif
+
+void translate_init(const stick_calibration_t *calibrations) {
+    pad_calibration = calibrations;
+}
+
+void translate_fill_sample(raw_sample_t *sample, const uni_gamepad_t *gp, uint8_t epoch, uint32_t now_us) {
+    sample->timestamp_us = now_us;
+    sample->buttons = gp->buttons;
+    sample->dpad = gp->dpad;
+    sample->misc_buttons = gp->misc_buttons;
+    sample->axes[0] = (int16_t)gp->axis_x;
+    sample->axes[1] = (int16_t)gp->axis_y;
+    sample->axes[2] = (int16_t)gp->axis_rx;
+    sample->axes[3] = (int16_t)gp->axis_ry;
+    sample->brake = (uint16_t)gp->brake;
+    sample->throttle = (uint16_t)gp->throttle;
+    memcpy(sample->gyro, gp->gyro, sizeof(sample->gyro));
+    sample->epoch = epoch;
+}
+
+static uint8_t translate_dpad(uint8_t dpad) {
+    switch (dpad) {
+        case DPAD_UP:
+            return SWITCH_HAT_UP;
+        case DPAD_DOWN:
+            return SWITCH_HAT_DOWN;
+        case DPAD_LEFT:
+            return SWITCH_HAT_LEFT;
+        case DPAD_RIGHT:
+            return SWITCH_HAT_RIGHT;
+        case DPAD_UP | DPAD_RIGHT:
+            return SWITCH_HAT_UPRIGHT;
+        case DPAD_DOWN | DPAD_RIGHT:
+            return SWITCH_HAT_DOWNRIGHT;
+        case DPAD_DOWN | DPAD_LEFT:
+            return SWITCH_HAT_DOWNLEFT;
+        case DPAD_UP | DPAD_LEFT:
+            return SWITCH_HAT_UPLEFT;
+        default:
+            return SWITCH_HAT_NOTHING;
+    }
+}
+
+static uint16_t translate_buttons(const raw_sample_t *sample, uint16_t pad_buttons) {
+    uint16_t buttons = 0;
+
+    // Face buttons
+    if (pad_buttons & BUTTON_A) {
+        buttons |= SWITCH_MASK_A;
+    }
+    if (pad_buttons & BUTTON_B) {
+        buttons |= SWITCH_MASK_B;
+    }
+    if (pad_buttons & BUTTON_X) {
+        buttons |= SWITCH_MASK_X;
+    }
+    if (pad_buttons & BUTTON_Y) {
+        buttons |= SWITCH_MASK_Y;
+    }
+
+    // Shoulder buttons
+    if (pad_buttons & BUTTON_SHOULDER_L) {
+        buttons |= SWITCH_MASK_L;
+    }
+    if (pad_buttons & BUTTON_SHOULDER_R) {
+        buttons |= SWITCH_MASK_R;
+    }
+
+    // Thumb buttons (L3/R3)
+    if (pad_buttons & BUTTON_THUMB_L) {
+        buttons |= SWITCH_MASK_L3;
+    }
+    if (pad_buttons & BUTTON_THUMB_R) {
+        buttons |= SWITCH_MASK_R3;
+    }
+
+    // Triggers (ZL/ZR) - check both analog and digital
+    if (sample->brake || (pad_buttons & BUTTON_TRIGGER_L)) {
+        buttons |= SWITCH_MASK_ZL;
+    }
+    if (sample->throttle || (pad_buttons & BUTTON_TRIGGER_R)) {
+        buttons |= SWITCH_MASK_ZR;
+    }
+
+    // Misc buttons
+    if (sample->misc_buttons & MISC_BUTTON_SYSTEM) {
+        buttons |= SWITCH_MASK_HOME;
+    }
+    if (sample->misc_buttons & MISC_BUTTON_CAPTURE) {
+        buttons |= SWITCH_MASK_CAPTURE;
+    }
+    if (sample->misc_buttons & MISC_BUTTON_BACK) {
+        buttons |= SWITCH_MASK_MINUS;
+    }
+    if (sample->misc_buttons & MISC_BUTTON_HOME) {
+        buttons |= SWITCH_MASK_PLUS;
+    }
+
+    return buttons;
+}
+
+void translate_pad(uint8_t pad, const raw_sample_t *sample, SwitchOutReport *report) {
+    translate_state_t *state = &pad_state[pad];
+    const stick_calibration_t *cal = &pad_calibration[pad];
+
+    if (!state->started || state->epoch != sample->epoch) {
+        state->started = true;
+        state->epoch = sample->epoch;
+#ifdef CONFIG_PICONTROLLER_STICK_FILTER
+        stick_filter_reset(&state->filter);
+#endif
+#ifdef CONFIG_PICONTROLLER_MOTION_AIM
+        motion_aim_reset(&state->aim);
+#endif
+    }
+
+    // A configured ratchet button only suspends motion aim, the console
+    // never sees it; without one every button passes through
+    uint16_t pad_buttons = sample->buttons;
+#ifdef CONFIG_PICONTROLLER_MOTION_AIM
+    bool ratchet = false;
+    if (CONFIG_PICONTROLLER_MOTION_AIM_RATCHET != 0) {
+        ratchet = (pad_buttons & CONFIG_PICONTROLLER_MOTION_AIM_RATCHET) != 0;
+        pad_buttons &= (uint16_t)~(CONFIG_PICONTROLLER_MOTION_AIM_RATCHET);
+    }
+#endif
+
+    report->buttons = translate_buttons(sample, pad_buttons);
+    report->hat = translate_dpad(sample->dpad);
+
+    // Analog sticks
+    int32_t axes[STICK_AXIS_COUNT];
+    for (int i = 0; i < STICK_AXIS_COUNT; i++) {
+        axes[i] = sample->axes[i];
+    }
+
+#ifdef CONFIG_PICONTROLLER_STICK_FILTER
+    uint32_t start = bench_start();
+    stick_filter_update(&state->filter, axes, sample->timestamp_us);
+    bench_stop(&stick_filter_bench, start);
+    if (stick_filter_bench.count >= BENCH_REPORT_INTERVAL) {
+        bench_print(&stick_filter_bench);
+    }
+#endif
+
+    // Calibration, deadzone and scaling in one table load per axis
+    uint8_t sticks[STICK_AXIS_COUNT];
+    stick_calibration_apply(cal, axes, sticks);
+    report->lx = sticks[0];
+    report->ly = sticks[1];
+    report->rx = sticks[2];
+    report->ry = sticks[3];
+
+#ifdef CONFIG_PICONTROLLER_MOTION_AIM
+    uint32_t aim_start = bench_start();
+    motion_aim_update(&state->aim, sample->gyro, ratchet, report);
+    bench_stop(&motion_aim_bench, aim_start);
+    if (motion_aim_bench.count >= BENCH_REPORT_INTERVAL) {
+        bench_print(&motion_aim_bench);
+    }
+#endif
+}
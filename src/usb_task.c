@@ -13,9 +13,43 @@
 #include <pico/stdlib.h>
 #include <pico/multicore.h>
 
+#include "sdkconfig.h"
+#include "bench.h"
+#include "governor.h"
+#include "kbm.h"
+#include "macro.h"
+#include "profile.h"
 #include "report.h"
 #include "switch_descriptors.h"
 
+// Print loop benchmarks every N measured iterations
+#define BENCH_LOOP_INTERVAL 100000
+
+// Per-stage and whole-iteration time of the main loop (Core 0)
+static bench_stat_t input_bench = BENCH_STAT_INIT("usb_input");
+static bench_stat_t tud_bench = BENCH_STAT_INIT("usb_tud_task");
+static bench_stat_t output_bench = BENCH_STAT_INIT("usb_output");
+static bench_stat_t loop_bench = BENCH_STAT_INIT("usb_loop");
+
+// Per-frame work (mouse drain, hotkey timing, macros and turbo) needs the
+// frame counter; without it SOF interrupts stay off
+#if defined(CONFIG_PICONTROLLER_KBM) || defined(CONFIG_PICONTROLLER_PROFILES) || defined(CONFIG_PICONTROLLER_MACRO)
+#define USB_FRAME_COUNTER 1
+#endif
+
+#ifdef USB_FRAME_COUNTER
+// USB frame counter, extended from the 11-bit SOF frame number
+static uint32_t usb_frame;
+static uint16_t last_sof_frame;
+
+// Called from tud_task() on every Start-of-Frame
+void tud_sof_cb(uint32_t frame_count) {
+    uint16_t sof = (uint16_t)(frame_count & 0x7FF);
+    usb_frame += (uint16_t)(sof - last_sof_frame) & 0x7FF;
+    last_sof_frame = sof;
+}
+#endif
+
 void usb_core_task(void) {
     printf("USB: Initializing TinyUSB...\n");
     tusb_init();
@@ -53,19 +87,85 @@ void usb_core_task(void) {
 
     printf("USB: Init complete, entering main loop\n");
 
+#ifdef USB_FRAME_COUNTER
+    // Frame counter for per-frame work (macros, turbo, mouse drain)
+    tud_sof_cb_enable(true);
+#endif
+
+#ifdef CONFIG_PICONTROLLER_KBM
+    uint32_t last_frame = usb_frame;
+#endif
+
+#ifdef CONFIG_PICONTROLLER_PROFILES
+    profile_init();
+#endif
+
+#ifdef CONFIG_PICONTROLLER_MACRO
+    macro_init(usb_frame);
+#endif
+
+    governor_init();
+
     // Main loop
     while (1) {
+        uint32_t loop_start = bench_start();
         get_global_gamepad_report(&report);
+        bench_stop(&input_bench, loop_start);
 
+        uint32_t start = bench_start();
         tud_task();
+        bench_stop(&tud_bench, start);
 
-        if (tud_suspended()) {
+        bool suspended = tud_suspended();
+        governor_poll(suspended);
+
+        if (suspended) {
             tud_remote_wakeup();
             continue;
         }
 
+#ifdef CONFIG_PICONTROLLER_KBM
+        // Drain mouse motion exactly once per USB frame
+        if (usb_frame != last_frame) {
+            kbm_mouse_frame(usb_frame - last_frame);
+            last_frame = usb_frame;
+        }
+        kbm_mouse_apply(&report);
+#endif
+
         if (tud_hid_ready()) {
+            start = bench_start();
+            // Chords are matched on the physical buttons, output is remapped
+#ifdef CONFIG_PICONTROLLER_PROFILES
+            profile_hotkeys(&report, usb_frame);
+#endif
+#ifdef CONFIG_PICONTROLLER_MACRO
+            macro_triggers(&report, usb_frame);
+#endif
+#ifdef CONFIG_PICONTROLLER_PROFILES
+            profile_apply(&report);
+#endif
+#ifdef CONFIG_PICONTROLLER_MACRO
+            macro_apply(&report, usb_frame);
+#endif
             tud_hid_report(0, &report, sizeof(report));
+            bench_stop(&output_bench, start);
+        }
+
+#ifdef CONFIG_PICONTROLLER_BENCH
+        // Core 0 loop time only; the input-to-send latency also includes
+        // Core 1, the report slot and host polling, none of which is
+        // measured here. Only counted with a controller connected, idle
+        // loops park in the governor
+        if (get_global_gamepad_any_active()) {
+            bench_stop(&loop_bench, loop_start);
+        }
+#endif
+        if (loop_bench.count >= BENCH_LOOP_INTERVAL) {
+            bench_print(&input_bench);
+            bench_print(&tud_bench);
+            bench_print(&output_bench);
+            bench_print(&loop_bench);
         }
     }
 }
@@ -0,0 +1,207 @@
+/*
+ * Host checks and benchmark of the fast-path report parsers (src/fast_parse.c)
+ *
+ * Checks what can be checked without bluepad32: every parser writes every
+ * field of the sample (the result does not depend on what the sample held
+ * before), and reports with a foreign ID or the wrong length, including
+ * the 16-byte Xbox layout of older firmware, are left to bluepad32. It
+ * then times each fast parser over a stream of reports whose stick bytes
+ * change every iteration and prints nanoseconds and, on x86, TSC cycles
+ * per report.
+ *
+ * It does not show that the decoded values match bluepad32, and the
+ * timings are host numbers for the fast path alone. bluepad32's parsers
+ * need uni_hid_device_t and the rest of bluepad32, so they are not built
+ * here. Both questions are answered on the target only:
+ * CONFIG_PICONTROLLER_FAST_PARSE_VERIFY runs both parsers on every report
+ * and logs each field that differs, and with CONFIG_PICONTROLLER_BENCH it
+ * logs the cycles of both parsers for each of the first reports
+ * ("fast_parse: ... cycles fast N generic N") and prints "parse_fast" and
+ * "parse_generic" summary lines.
+ *
+ * Build and run on the host:
+ *   cc -O2 -Itools/host -Iinclude -Isrc tools/fast_parse_bench.c src/fast_parse.c -o fast_parse_bench
+ *   ./fast_parse_bench [iterations]
+ */
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+
+#include <uni.h>
+
+#include "fast_parse.h"
+
+typedef struct {
+    const char *name;
+    fast_parse_fn_t parse;
+    uint8_t report[80];
+    uint16_t len;
+    uint16_t stick_offset;  // byte changed between benchmark iterations
+} parser_case_t;
+
+static parser_case_t cases[3];
+
+static void put_u16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+// Full right, full up, cross + L1, options + PS, D-pad right, L2 pressed
+static void build_ds4(parser_case_t *c) {
+    c->name = "ds4";
+    c->parse = fast_parse_ds4;
+    c->len = 78;
+    c->report[0] = 0x11;
+    uint8_t *r = c->report + 3;
+    r[0] = 255;
+    r[1] = 0;
+    r[2] = 127;
+    r[3] = 127;
+    r[4] = 0x20 | 2;
+    r[5] = 0x01 | 0x20;
+    r[6] = 0x01;
+    r[7] = 255;
+    put_u16(r + 12, (uint16_t)-100);
+    c->stick_offset = 3;
+}
+
+// Same inputs in the DualSense layout
+static void build_ds5(parser_case_t *c) {
+    c->name = "ds5";
+    c->parse = fast_parse_ds5;
+    c->len = 78;
+    c->report[0] = 0x31;
+    uint8_t *r = c->report + 2;
+    r[0] = 255;
+    r[1] = 0;
+    r[2] = 127;
+    r[3] = 127;
+    r[4] = 255;
+    r[7] = 0x20 | 2;
+    r[8] = 0x01 | 0x20;
+    r[9] = 0x01;
+    put_u16(r + 15, (uint16_t)-100);
+    c->stick_offset = 2;
+}
+
+// Full right, full up, A, Xbox button, D-pad right, LT pressed
+static void build_xbox(parser_case_t *c) {
+    c->name = "xbox";
+    c->parse = fast_parse_xbox;
+    c->len = 17;
+    c->report[0] = 0x01;
+    uint8_t *r = c->report + 1;
+    put_u16(r + 0, 65535);
+    put_u16(r + 2, 0);
+    put_u16(r + 4, 32768);
+    put_u16(r + 6, 32768);
+    put_u16(r + 8, 1023);
+    r[12] = 3;
+    r[13] = 0x01;
+    r[14] = 0x10;
+    c->stick_offset = 2;
+}
+
+// Parse into a sample filled with fill; timestamp and epoch belong to the caller
+static bool parse_filled(const parser_case_t *c, uint8_t fill, raw_sample_t *s) {
+    memset(s, fill, sizeof(*s));
+    bool ok = c->parse(c->report, c->len, s);
+    s->timestamp_us = 0;
+    s->epoch = 0;
+    return ok;
+}
+
+static int check(const parser_case_t *c) {
+    int errors = 0;
+    raw_sample_t zero;
+    raw_sample_t ones;
+    if (!parse_filled(c, 0x00, &zero) || !parse_filled(c, 0xFF, &ones)) {
+        printf("%-8s rejected its own report\n", c->name);
+        return 1;
+    }
+    if (memcmp(&zero, &ones, offsetof(raw_sample_t, epoch)) != 0) {
+        printf("%-8s leaves part of the sample unwritten\n", c->name);
+        errors++;
+    }
+
+    // A different report ID or length must fall back to bluepad32
+    uint8_t other[80];
+    memcpy(other, c->report, sizeof(other));
+    other[0] ^= 0x80;
+    raw_sample_t s;
+    if (c->parse(other, c->len, &s) || c->parse(c->report, 4, &s)) {
+        printf("%-8s accepted a foreign or short report\n", c->name);
+        errors++;
+    }
+    if (c->parse == fast_parse_xbox &&
+        (c->parse(c->report, c->len - 1, &s) || c->parse(c->report, c->len + 1, &s))) {
+        printf("%-8s accepted a report of another firmware layout\n", c->name);
+        errors++;
+    }
+    return errors;
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void bench(parser_case_t *c, long iterations) {
+    raw_sample_t s;
+    volatile int32_t sink = 0;
+
+    double start_ns = now_ns();
+#ifdef HAVE_TSC
+    uint64_t start_tsc = __rdtsc();
+#endif
+    for (long i = 0; i < iterations; i++) {
+        c->report[c->stick_offset] = (uint8_t)i;
+        c->parse(c->report, c->len, &s);
+        sink += s.axes[0] + s.buttons;
+    }
+#ifdef HAVE_TSC
+    uint64_t tsc = __rdtsc() - start_tsc;
+#endif
+    double ns = now_ns() - start_ns;
+    (void)sink;
+
+#ifdef HAVE_TSC
+    printf("%-8s %10.2f %12.2f\n", c->name, ns / iterations, (double)tsc / iterations);
+#else
+    printf("%-8s %10.2f %12s\n", c->name, ns / iterations, "-");
+#endif
+}
+
+int main(int argc, char **argv) {
+    long iterations = argc >= 2 ? atol(argv[1]) : 10000000;
+    if (iterations <= 0) {
+        fprintf(stderr, "usage: %s [iterations]\n", argv[0]);
+        return 1;
+    }
+
+    build_ds4(&cases[0]);
+    build_ds5(&cases[1]);
+    build_xbox(&cases[2]);
+
+    int errors = 0;
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        errors += check(&cases[i]);
+    }
+    printf("field and length checks: %s\n", errors ? "FAILED" : "ok");
+
+    printf("fast path on this host (not target numbers)\n");
+    printf("%-8s %10s %12s\n", "parser", "ns/report", "tsc/report");
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        bench(&cases[i], iterations);
+    }
+
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,12 @@
+/*
+ * Host stand-in for BTstack's bluetooth.h, used by tools/fast_parse_bench.c
+ */
+
+#ifndef _HOST_BLUETOOTH_H_
+#define _HOST_BLUETOOTH_H_
+
+#include <stdint.h>
+
+typedef uint8_t bd_addr_t[6];
+
+#endif /* _HOST_BLUETOOTH_H_ */
@@ -0,0 +1,10 @@
+/*
+ * Host stand-in for BTstack's btstack_stdin.h, used by tools/inject_check.c
+ */
+
+#ifndef _HOST_BTSTACK_STDIN_H_
+#define _HOST_BTSTACK_STDIN_H_
+
+void btstack_stdin_setup(void (*handler)(char c));
+
+#endif /* _HOST_BTSTACK_STDIN_H_ */
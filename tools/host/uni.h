@@ -0,0 +1,50 @@
+/*
+ * Host stand-in for bluepad32's uni.h, used by tools/fast_parse_bench.c
+ * and tools/inject_check.c. Only the gamepad constants and fields those
+ * sources use (values from bluepad32's controller/uni_gamepad.h).
+ */
+
+#ifndef _HOST_UNI_H_
+#define _HOST_UNI_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "bluetooth.h"
+
+#define DPAD_UP (1 << 0)
+#define DPAD_DOWN (1 << 1)
+#define DPAD_RIGHT (1 << 2)
+#define DPAD_LEFT (1 << 3)
+
+#define BUTTON_A (1 << 0)
+#define BUTTON_B (1 << 1)
+#define BUTTON_X (1 << 2)
+#define BUTTON_Y (1 << 3)
+#define BUTTON_SHOULDER_L (1 << 4)
+#define BUTTON_SHOULDER_R (1 << 5)
+#define BUTTON_TRIGGER_L (1 << 6)
+#define BUTTON_TRIGGER_R (1 << 7)
+#define BUTTON_THUMB_L (1 << 8)
+#define BUTTON_THUMB_R (1 << 9)
+
+#define MISC_BUTTON_SYSTEM (1 << 0)
+#define MISC_BUTTON_BACK (1 << 1)
+#define MISC_BUTTON_HOME (1 << 2)
+#define MISC_BUTTON_CAPTURE (1 << 3)
+
+typedef struct uni_gamepad_s {
+    uint8_t dpad;
+    uint16_t buttons;
+    uint8_t misc_buttons;
+    int32_t axis_x;
+    int32_t axis_y;
+    int32_t axis_rx;
+    int32_t axis_ry;
+    int32_t brake;
+    int32_t throttle;
+} uni_gamepad_t;
+
+#define logi(...) printf(__VA_ARGS__)
+
+#endif /* _HOST_UNI_H_ */
@@ -0,0 +1,179 @@
+#!/usr/bin/env python3
+"""
+Virtual controller frame generator for CONFIG_PICONTROLLER_INJECT.
+
+Streams gamepad states to the adapter's debug UART in the frame format
+described in include/inject.h. Patterns are scripted below; the rate is
+frames per second, or 0 to send as fast as the link accepts (saturation).
+
+Examples:
+    tools/inject.py --port /dev/ttyUSB0 --pattern circle --rate 250
+    tools/inject.py --port /dev/ttyUSB0 --pattern square --period 100
+    tools/inject.py --port /dev/ttyUSB0 --pattern buttons --rate 0 --duration 30
+    tools/inject.py --output frames.bin --pattern circle --count 1000
+
+Requires pyserial unless --output is used.
+"""
+
+import argparse
+import math
+import struct
+import sys
+import time
+
+SYNC = b"\xA5\x5A"
+FLAG_DISCONNECT = 0x10
+FRAME_SIZE = 21
+
+# bluepad32 bit assignments (uni_gamepad.h)
+BUTTON_A = 1 << 0
+BUTTON_B = 1 << 1
+BUTTON_X = 1 << 2
+BUTTON_Y = 1 << 3
+BUTTON_SHOULDER_L = 1 << 4
+BUTTON_SHOULDER_R = 1 << 5
+BUTTON_TRIGGER_L = 1 << 6
+BUTTON_TRIGGER_R = 1 << 7
+BUTTON_THUMB_L = 1 << 8
+BUTTON_THUMB_R = 1 << 9
+
+DPAD_UP = 1 << 0
+DPAD_DOWN = 1 << 1
+DPAD_RIGHT = 1 << 2
+DPAD_LEFT = 1 << 3
+
+AXIS_MAX = 511
+
+
+def encode(slot, sequence, state, flags=0):
+    body = struct.pack(
+        "<BBHBBhhhhHH",
+        (slot & 0x0F) | flags,
+        sequence & 0xFF,
+        state.get("buttons", 0),
+        state.get("dpad", 0),
+        state.get("misc", 0),
+        state.get("x", 0),
+        state.get("y", 0),
+        state.get("rx", 0),
+        state.get("ry", 0),
+        state.get("brake", 0),
+        state.get("throttle", 0),
+    )
+    checksum = (-sum(body)) & 0xFF
+    frame = SYNC + body + bytes([checksum])
+    assert len(frame) == FRAME_SIZE
+    return frame
+
+
+#
+# Patterns: frame index -> state
+#
+
+def pattern_neutral(n, args):
+    return {}
+
+
+def pattern_square(n, args):
+    # A pressed for half of each period: edges for latency measurement
+    pressed = (n // max(1, args.period // 2)) % 2 == 1
+    return {"buttons": BUTTON_A if pressed else 0}
+
+
+def pattern_buttons(n, args):
+    # Walk one button at a time, then each D-pad direction
+    steps = [{"buttons": 1 << i} for i in range(10)]
+    steps += [{"dpad": d} for d in (DPAD_UP, DPAD_RIGHT, DPAD_DOWN, DPAD_LEFT)]
+    return steps[(n // max(1, args.period)) % len(steps)]
+
+
+def pattern_circle(n, args):
+    # Both sticks trace full circles, right stick in the other direction
+    angle = 2 * math.pi * n / max(1, args.period)
+    x = int(AXIS_MAX * math.cos(angle))
+    y = int(AXIS_MAX * math.sin(angle))
+    return {"x": x, "y": y, "rx": -x, "ry": y}
+
+
+def pattern_sweep(n, args):
+    # Left X axis ramps across the whole range (checks the full LUT)
+    span = 2 * AXIS_MAX + 1
+    return {"x": (n % span) - AXIS_MAX - 1}
+
+
+PATTERNS = {
+    "neutral": pattern_neutral,
+    "square": pattern_square,
+    "buttons": pattern_buttons,
+    "circle": pattern_circle,
+    "sweep": pattern_sweep,
+}
+
+
+def open_output(args):
+    if args.output:
+        return open(args.output, "wb")
+    try:
+        import serial
+    except ImportError:
+        sys.exit("pyserial is required for --port (pip install pyserial)")
+    return serial.Serial(args.port, args.baud, write_timeout=None)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--port", help="serial port connected to the adapter UART")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--output", help="write frames to a file instead of a port")
+    parser.add_argument("--pattern", choices=sorted(PATTERNS), default="circle")
+    parser.add_argument("--rate", type=float, default=250.0, help="frames per second, 0 = saturate")
+    parser.add_argument("--period", type=int, default=200, help="pattern period in frames")
+    parser.add_argument("--slot", type=int, default=0, help="virtual controller slot (below CONFIG_PICONTROLLER_INJECT_SLOTS)")
+    parser.add_argument("--duration", type=float, default=0.0, help="seconds to run, 0 = until Ctrl-C")
+    parser.add_argument("--count", type=int, default=0, help="frames to send, 0 = unlimited")
+    args = parser.parse_args()
+
+    if not args.port and not args.output:
+        parser.error("one of --port or --output is required")
+
+    link_limit = args.baud / 10 / FRAME_SIZE
+    if args.port:
+        print(f"link limit at {args.baud} baud: {link_limit:.0f} frames/s", file=sys.stderr)
+        if args.rate > link_limit:
+            print("requested rate exceeds the link, running saturated", file=sys.stderr)
+
+    out = open_output(args)
+    pattern = PATTERNS[args.pattern]
+    interval = 1.0 / args.rate if args.rate > 0 else 0.0
+
+    start = time.monotonic()
+    next_time = start
+    sent = 0
+    try:
+        while True:
+            if args.count and sent >= args.count:
+                break
+            if args.duration and time.monotonic() - start >= args.duration:
+                break
+
+            out.write(encode(args.slot, sent, pattern(sent, args)))
+            sent += 1
+
+            if interval:
+                next_time += interval
+                delay = next_time - time.monotonic()
+                if delay > 0:
+                    time.sleep(delay)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        out.write(encode(args.slot, sent, {}, FLAG_DISCONNECT))
+        out.flush()
+        elapsed = time.monotonic() - start
+        if elapsed > 0:
+            print(f"sent {sent} frames in {elapsed:.1f} s ({sent / elapsed:.0f} frames/s)", file=sys.stderr)
+        out.close()
+
+
+if __name__ == "__main__":
+    main()
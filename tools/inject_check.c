@@ -0,0 +1,168 @@
+/*
+ * Host check of the virtual controller frame parser (src/inject.c)
+ *
+ * Feeds a capture from tools/inject.py through the firmware parser twice:
+ * once as written, where every frame must decode, and once with a burst
+ * of junk bytes (log text, stray sync bytes, a truncated frame) after
+ * every Nth frame. The second pass must decode every frame of the first,
+ * in order. The 8-bit checksum lets about 1 in 256 corrupt frames
+ * through; those are counted, and each one may cost the good frame it
+ * overlapped.
+ *
+ * Build and run on the host:
+ *   cc -O2 -Itools/host -Iinclude -Isrc tools/inject_check.c src/inject.c -o inject_check
+ *   tools/inject.py --output frames.bin --pattern circle --count 1000
+ *   ./inject_check frames.bin [burst_every]
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "inject.h"
+
+#define MAX_FRAMES 100000
+
+// Corrupt frames looked past when matching; patterns repeat, so a lost
+// frame must not be matched against a later copy of the same state
+#define MATCH_WINDOW 4
+
+typedef struct {
+    uint8_t slot;
+    bool disconnect;
+    uni_gamepad_t gp;
+} decoded_t;
+
+static void (*stdin_handler)(char c);
+
+static decoded_t *decoded;
+static long decoded_count;
+
+void btstack_stdin_setup(void (*handler)(char c)) {
+    stdin_handler = handler;
+}
+
+static void record(uint8_t slot, uni_gamepad_t *gp) {
+    if (decoded_count >= MAX_FRAMES) {
+        return;
+    }
+    decoded_t *d = &decoded[decoded_count++];
+    memset(d, 0, sizeof(*d));
+    d->slot = slot;
+    d->disconnect = gp == NULL;
+    if (gp) {
+        d->gp = *gp;
+    }
+}
+
+static void feed(const uint8_t *data, long len) {
+    for (long i = 0; i < len; i++) {
+        stdin_handler((char)data[i]);
+    }
+}
+
+static bool same(const decoded_t *a, const decoded_t *b) {
+    return a->slot == b->slot && a->disconnect == b->disconnect && memcmp(&a->gp, &b->gp, sizeof(a->gp)) == 0;
+}
+
+// Junk between frames: log text, a lone sync byte, a frame cut short
+static void feed_burst(const uint8_t *frame) {
+    static const char text[] = "inject: 1000 frames, 0 bad, 0 lost\n";
+    feed((const uint8_t *)text, sizeof(text) - 1);
+    feed((const uint8_t[]){ INJECT_SYNC0, 0x00, INJECT_SYNC0 }, 3);
+    feed(frame, INJECT_FRAME_SIZE / 2);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s frames.bin [burst_every]\n", argv[0]);
+        return 1;
+    }
+    long burst_every = argc >= 3 ? atol(argv[2]) : 7;
+    if (burst_every <= 0) {
+        burst_every = 7;
+    }
+
+    FILE *f = fopen(argv[1], "rb");
+    if (!f) {
+        perror(argv[1]);
+        return 1;
+    }
+    static uint8_t data[MAX_FRAMES * INJECT_FRAME_SIZE];
+    long len = (long)fread(data, 1, sizeof(data), f);
+    fclose(f);
+
+    long frames = len / INJECT_FRAME_SIZE;
+    if (frames == 0 || len % INJECT_FRAME_SIZE != 0) {
+        fprintf(stderr, "%s: not a whole number of %d-byte frames\n", argv[1], INJECT_FRAME_SIZE);
+        return 1;
+    }
+
+    decoded_t *clean = calloc(MAX_FRAMES, sizeof(decoded_t));
+    decoded_t *noisy = calloc(MAX_FRAMES, sizeof(decoded_t));
+    if (!clean || !noisy) {
+        return 1;
+    }
+
+    // Pass 1: the capture as written
+    decoded = clean;
+    decoded_count = 0;
+    inject_start(record);
+    feed(data, len);
+    long clean_count = decoded_count;
+
+    // Pass 2: junk after every burst_every frames
+    decoded = noisy;
+    decoded_count = 0;
+    inject_start(record);
+    long bursts = 0;
+    for (long i = 0; i < frames; i++) {
+        const uint8_t *frame = &data[i * INJECT_FRAME_SIZE];
+        feed(frame, INJECT_FRAME_SIZE);
+        if (i % burst_every == burst_every - 1) {
+            feed_burst(frame);
+            bursts++;
+        }
+    }
+    long noisy_count = decoded_count;
+
+    int failures = 0;
+    if (clean_count != frames) {
+        printf("FAIL clean: %ld of %ld frames decoded\n", clean_count, frames);
+        failures++;
+    }
+
+    // Walk both decodes in order; noisy results missing from the clean
+    // decode are corrupt frames that passed the checksum
+    long lost = 0;
+    long accepted = 0;
+    long n = 0;
+    for (long c = 0; c < clean_count; c++) {
+        long match = n;
+        while (match < noisy_count && match - n < MATCH_WINDOW && !same(&clean[c], &noisy[match])) {
+            match++;
+        }
+        if (match == noisy_count || match - n == MATCH_WINDOW) {
+            lost++;
+            continue;
+        }
+        accepted += match - n;
+        n = match + 1;
+    }
+    accepted += noisy_count - n;
+    if (lost > accepted) {
+        printf("FAIL noisy: %ld frames lost, %ld corrupt frames accepted\n", lost, accepted);
+        failures++;
+    }
+
+    printf("%ld frames: clean %ld decoded; %ld junk bursts: %ld lost, %ld corrupt accepted\n", frames, clean_count,
+           bursts, lost, accepted);
+    free(clean);
+    free(noisy);
+    if (failures) {
+        return 1;
+    }
+    printf("inject parser OK\n");
+    return 0;
+}
@@ -0,0 +1,88 @@
+/*
+ * Host benchmark of the motion aim stage (src/motion_aim.c)
+ *
+ * Feeds a synthetic gyro stream (slow pans, flicks and rest, so every
+ * branch of the filter and acceleration curve is taken) through
+ * motion_aim_update() and prints nanoseconds and, on x86, TSC cycles per
+ * sample. On the target the same stage is timed by CONFIG_PICONTROLLER_BENCH
+ * ("motion_aim" lines in the UART log).
+ *
+ * Build and run on the host:
+ *   cc -O2 -Iinclude -Isrc tools/motion_aim_bench.c src/motion_aim.c -o motion_aim_bench
+ *   ./motion_aim_bench [samples]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+
+#include "motion_aim.h"
+
+#define PATTERN_LEN 1024
+
+static int32_t pattern[PATTERN_LEN][3];
+
+// Rest, slow pan, fast flick and back, in gyro counts (16 per deg/s)
+static void build_pattern(void) {
+    for (int i = 0; i < PATTERN_LEN; i++) {
+        int32_t rate;
+        if (i < 256) {
+            rate = (i & 7) - 4;
+        } else if (i < 512) {
+            rate = 40 * 16;
+        } else if (i < 640) {
+            rate = (i - 512) * 300;
+        } else {
+            rate = -(int32_t)(PATTERN_LEN - i) * 40;
+        }
+        pattern[i][0] = rate / 2;
+        pattern[i][1] = rate;
+        pattern[i][2] = 0;
+    }
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main(int argc, char **argv) {
+    long samples = argc >= 2 ? atol(argv[1]) : 10000000;
+    if (samples <= 0) {
+        fprintf(stderr, "usage: %s [samples]\n", argv[0]);
+        return 1;
+    }
+
+    build_pattern();
+
+    motion_aim_t aim;
+    motion_aim_reset(&aim);
+    volatile uint32_t sink = 0;
+
+    double start_ns = now_ns();
+#ifdef HAVE_TSC
+    uint64_t start_tsc = __rdtsc();
+#endif
+    for (long i = 0; i < samples; i++) {
+        SwitchOutReport report = { .rx = SWITCH_JOYSTICK_MID, .ry = SWITCH_JOYSTICK_MID };
+        motion_aim_update(&aim, pattern[i & (PATTERN_LEN - 1)], (i & 0xFFF) < 16, &report);
+        sink += report.rx + report.ry;
+    }
+#ifdef HAVE_TSC
+    uint64_t tsc = __rdtsc() - start_tsc;
+#endif
+    double ns = now_ns() - start_ns;
+    (void)sink;
+
+#ifdef HAVE_TSC
+    printf("motion_aim %.2f ns/sample, %.2f tsc/sample\n", ns / samples, (double)tsc / samples);
+#else
+    printf("motion_aim %.2f ns/sample\n", ns / samples);
+#endif
+    return 0;
+}
@@ -0,0 +1,235 @@
+/*
+ * Offline evaluation of the stick extrapolation (src/stick_predict.c)
+ *
+ * Replays a recorded stick trace through the firmware predictor at a 1 ms
+ * USB frame rate and compares, for a range of horizons, the sent stick
+ * position against the motion the trace describes (linear between
+ * samples). Reports RMS and worst-case error and the effective lag, found
+ * as the time shift that best aligns the output with the trace; "saved"
+ * is the lag removed compared with holding the last sample.
+ *
+ * Traces come from CONFIG_PICONTROLLER_STICK_TRACE ("trace:" lines in the
+ * UART log, other lines are ignored). Without a file a synthetic trace is
+ * generated instead.
+ *
+ * Build and run on the host:
+ *   cc -O2 -Iinclude -Isrc tools/stick_predict_eval.c src/stick_predict.c -lm -o stick_predict_eval
+ *   ./stick_predict_eval uart.log [pad]
+ *   ./stick_predict_eval --synthetic [interval_ms]
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "stick_predict.h"
+
+#define MAX_SAMPLES 200000
+#define FRAME_US 1000
+#define MAX_LAG_US 20000
+#define LAG_STEP_US 250
+
+typedef struct {
+    uint32_t us;
+    uint8_t axis[STICK_PREDICT_AXES];
+} sample_t;
+
+static sample_t samples[MAX_SAMPLES];
+static int sample_count;
+
+static uint8_t *frames_out[STICK_PREDICT_AXES];
+static int frame_count;
+
+static const uint32_t horizons_us[] = { 0, 2000, 4000, 6000, 8000, 10000, 12000, 16000 };
+
+// Nominal conversion from bluepad32 units (no calibration or deadzone)
+static uint8_t to_switch(int raw) {
+    int v = (raw + 512) >> 2;
+    return (uint8_t)(v < 0 ? 0 : (v > 255 ? 255 : v));
+}
+
+static int load_trace(const char *path, int pad) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+
+    char line[256];
+    while (fgets(line, sizeof(line), f) && sample_count < MAX_SAMPLES) {
+        const char *p = strstr(line, "trace:");
+        int idx, x, y, rx, ry;
+        unsigned long us;
+        if (!p || sscanf(p, "trace: %d %lu %d %d %d %d", &idx, &us, &x, &y, &rx, &ry) != 6 || idx != pad) {
+            continue;
+        }
+        sample_t *s = &samples[sample_count++];
+        s->us = (uint32_t)us;
+        s->axis[0] = to_switch(x);
+        s->axis[1] = to_switch(y);
+        s->axis[2] = to_switch(rx);
+        s->axis[3] = to_switch(ry);
+    }
+    fclose(f);
+    return 0;
+}
+
+// Thumb motion: sweeps of varying speed, flicks, holds and releases,
+// sampled at a jittered Bluetooth report interval
+static void synthesize(double interval_ms) {
+    srand(1);
+    double t_ms = 0;
+    while (sample_count < MAX_SAMPLES && t_ms < 60000) {
+        double phase = t_ms / 1000.0;
+        double sweep = 400 * sin(2 * M_PI * (0.3 + 0.2 * sin(phase * 0.5)) * phase);
+        double flick = fmod(phase, 4.0) < 0.15 ? 500 * sin(M_PI * fmod(phase, 4.0) / 0.15) : 0;
+        bool released = fmod(phase, 10.0) > 8.5;
+
+        sample_t *s = &samples[sample_count++];
+        s->us = (uint32_t)(t_ms * 1000);
+        s->axis[0] = to_switch(released ? 0 : (int)(sweep + flick));
+        s->axis[1] = to_switch(released ? 0 : (int)(300 * cos(2 * M_PI * 0.7 * phase)));
+        s->axis[2] = to_switch(released ? 0 : (int)flick);
+        s->axis[3] = to_switch(0);
+
+        double jitter = ((rand() % 1000) / 1000.0 - 0.5) * interval_ms * 0.5;
+        t_ms += interval_ms + jitter;
+    }
+}
+
+// Trace position at time us (linear between samples)
+static double truth(int axis, int64_t us) {
+    if (us <= samples[0].us) {
+        return samples[0].axis[axis];
+    }
+    if (us >= samples[sample_count - 1].us) {
+        return samples[sample_count - 1].axis[axis];
+    }
+
+    // First sample at or after us
+    int lo = 1;
+    int hi = sample_count - 1;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (samples[mid].us < us) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    const sample_t *a = &samples[lo - 1];
+    const sample_t *b = &samples[lo];
+    double f = (double)(us - a->us) / (double)(b->us - a->us);
+    return a->axis[axis] + f * (b->axis[axis] - a->axis[axis]);
+}
+
+// Run the predictor over the trace, one output per USB frame
+static void simulate(uint32_t horizon_us) {
+    stick_predict_t predict;
+    stick_predict_reset(&predict, horizon_us);
+
+    int k = 0;
+    frame_count = 0;
+    for (uint32_t t = samples[0].us; t <= samples[sample_count - 1].us; t += FRAME_US) {
+        while (k + 1 < sample_count && samples[k + 1].us <= t) {
+            k++;
+        }
+
+        SwitchOutReport report = {
+            .lx = samples[k].axis[0],
+            .ly = samples[k].axis[1],
+            .rx = samples[k].axis[2],
+            .ry = samples[k].axis[3],
+        };
+        stick_predict_apply(&predict, samples[k].us, t, &report);
+
+        frames_out[0][frame_count] = report.lx;
+        frames_out[1][frame_count] = report.ly;
+        frames_out[2][frame_count] = report.rx;
+        frames_out[3][frame_count] = report.ry;
+        frame_count++;
+    }
+}
+
+// RMS error of the output against the trace delayed by lag_us
+static double rms_error(uint32_t lag_us, double *max_error) {
+    double sum = 0;
+    double worst = 0;
+    long n = 0;
+    for (int axis = 0; axis < STICK_PREDICT_AXES; axis++) {
+        for (int i = 0; i < frame_count; i++) {
+            int64_t t = (int64_t)samples[0].us + (int64_t)i * FRAME_US;
+            double e = frames_out[axis][i] - truth(axis, t - lag_us);
+            sum += e * e;
+            if (fabs(e) > worst) {
+                worst = fabs(e);
+            }
+            n++;
+        }
+    }
+    if (max_error) {
+        *max_error = worst;
+    }
+    return n ? sqrt(sum / n) : 0;
+}
+
+static uint32_t effective_lag(void) {
+    uint32_t best_lag = 0;
+    double best = -1;
+    for (uint32_t lag = 0; lag <= MAX_LAG_US; lag += LAG_STEP_US) {
+        double e = rms_error(lag, NULL);
+        if (best < 0 || e < best) {
+            best = e;
+            best_lag = lag;
+        }
+    }
+    return best_lag;
+}
+
+int main(int argc, char **argv) {
+    if (argc >= 2 && strcmp(argv[1], "--synthetic") == 0) {
+        synthesize(argc >= 3 ? atof(argv[2]) : 8.0);
+    } else if (argc >= 2) {
+        if (load_trace(argv[1], argc >= 3 ? atoi(argv[2]) : 0) < 0) {
+            return 1;
+        }
+    } else {
+        fprintf(stderr, "usage: %s trace.log [pad] | --synthetic [interval_ms]\n", argv[0]);
+        return 1;
+    }
+
+    if (sample_count < 2) {
+        fprintf(stderr, "not enough samples\n");
+        return 1;
+    }
+
+    uint32_t span_us = samples[sample_count - 1].us - samples[0].us;
+    printf("%d samples over %.1f s, mean interval %.2f ms\n",
+           sample_count, span_us / 1e6, span_us / 1e3 / (sample_count - 1));
+
+    size_t frames = span_us / FRAME_US + 1;
+    for (int axis = 0; axis < STICK_PREDICT_AXES; axis++) {
+        frames_out[axis] = malloc(frames);
+    }
+
+    printf("%10s %10s %10s %10s %10s\n", "horizon_ms", "rms_err", "max_err", "lag_ms", "saved_ms");
+    uint32_t hold_lag = 0;
+    for (size_t h = 0; h < sizeof(horizons_us) / sizeof(horizons_us[0]); h++) {
+        simulate(horizons_us[h]);
+
+        double max_error;
+        double rms = rms_error(0, &max_error);
+        uint32_t lag = effective_lag();
+        if (horizons_us[h] == 0) {
+            hold_lag = lag;
+        }
+
+        printf("%10.1f %10.2f %10.0f %10.2f %10.2f\n", horizons_us[h] / 1e3, rms, max_error,
+               lag / 1e3, ((double)hold_lag - (double)lag) / 1e3);
+    }
+
+    return 0;
+}